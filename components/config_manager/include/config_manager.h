@@ -14,6 +14,7 @@ typedef struct {
 } app_config_t;
 
 bool config_manager_init(const char *config_path);
+bool config_manager_parse(const char *json, size_t len);
 const app_config_t* config_manager_get(void);
 
 #endif // CONFIG_MANAGER_H
@@ -2,12 +2,22 @@
 #include "esp_log.h"
 #include "cJSON.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #define TAG "CONFIG"
 
 static app_config_t config;
 
+// Copy a JSON string value, always NUL-terminating; non-string values are ignored
+static void copy_string(char* dst, size_t dst_size, const cJSON* item) {
+    if (!cJSON_IsString(item) || item->valuestring == NULL) {
+        return;
+    }
+    strncpy(dst, item->valuestring, dst_size - 1);
+    dst[dst_size - 1] = '\0';
+}
+
 bool config_manager_init(const char* path) {
     if (!path) {
         ESP_LOGE(TAG, "Null config path");
@@ -45,9 +55,17 @@ bool config_manager_init(const char* path) {
     }
     json_str[fsize] = 0;
 
-    cJSON* root = cJSON_Parse(json_str);
+    bool ok = config_manager_parse(json_str, fsize);
     free(json_str);
-    
+    return ok;
+}
+
+bool config_manager_parse(const char* json, size_t len) {
+    if (!json) {
+        return false;
+    }
+
+    cJSON* root = cJSON_ParseWithLength(json, len);
     if (!root) {
         const char* error_ptr = cJSON_GetErrorPtr();
         if (error_ptr) {
@@ -62,15 +80,15 @@ bool config_manager_init(const char* path) {
         cJSON* user = cJSON_GetObjectItem(mqtt, "username");
         cJSON* pass = cJSON_GetObjectItem(mqtt, "password");
         
-        if (uri) strncpy(config.mqtt_uri, uri->valuestring, sizeof(config.mqtt_uri));
-        if (user) strncpy(config.mqtt_username, user->valuestring, sizeof(config.mqtt_username));
-        if (pass) strncpy(config.mqtt_password, pass->valuestring, sizeof(config.mqtt_password));
+        copy_string(config.mqtt_uri, sizeof(config.mqtt_uri), uri);
+        copy_string(config.mqtt_username, sizeof(config.mqtt_username), user);
+        copy_string(config.mqtt_password, sizeof(config.mqtt_password), pass);
     }
 
     cJSON* topics = cJSON_GetObjectItem(root, "topics");
     if (topics) {
         cJSON* prefix = cJSON_GetObjectItem(topics, "prefix");
-        if (prefix) strncpy(config.topic_prefix, prefix->valuestring, sizeof(config.topic_prefix));
+        copy_string(config.topic_prefix, sizeof(config.topic_prefix), prefix);
     }
     
     cJSON* wifi = cJSON_GetObjectItem(root, "wifi");
@@ -78,8 +96,8 @@ bool config_manager_init(const char* path) {
         cJSON* ssid = cJSON_GetObjectItem(wifi, "ssid");
         cJSON* pass = cJSON_GetObjectItem(wifi, "password");
         
-        if (ssid) strncpy(config.wifi_ssid, ssid->valuestring, sizeof(config.wifi_ssid));
-        if (pass) strncpy(config.wifi_password, pass->valuestring, sizeof(config.wifi_password));
+        copy_string(config.wifi_ssid, sizeof(config.wifi_ssid), ssid);
+        copy_string(config.wifi_password, sizeof(config.wifi_password), pass);
     }
 
     cJSON_Delete(root);
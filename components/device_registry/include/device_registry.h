@@ -0,0 +1,76 @@
+#ifndef DEVICE_REGISTRY_H
+#define DEVICE_REGISTRY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Overridable for host benchmarks; slots must be a power of two and should
+// be at least twice DEVICE_MAX to keep probe chains short
+#ifndef DEVICE_MAX
+#define DEVICE_MAX              64
+#endif
+#ifndef DEVICE_REGISTRY_SLOTS
+#define DEVICE_REGISTRY_SLOTS   128
+#endif
+
+#define DEVICE_INDEX_NONE       (-1)
+
+// A MAC packed into the low 48 bits, first octet most significant
+static inline uint64_t mac_pack(const uint8_t mac[6]) {
+    return ((uint64_t)mac[0] << 40) | ((uint64_t)mac[1] << 32) | ((uint64_t)mac[2] << 24) |
+           ((uint64_t)mac[3] << 16) | ((uint64_t)mac[4] << 8) | mac[5];
+}
+
+static inline void mac_unpack(uint64_t key, uint8_t mac[6]) {
+    for (int i = 5; i >= 0; i--) {
+        mac[i] = (uint8_t)key;
+        key >>= 8;
+    }
+}
+
+// Maps MACs to small, stable device indices (0 .. DEVICE_MAX - 1) that
+// per-device state arrays are indexed with. An index stays bound to its MAC
+// until removed. Open addressing with linear probing over one array of
+// packed words: MAC in the low 48 bits, index + 1 in the high 16, 0 = empty.
+// Plain data without locking; the owner serializes access.
+typedef struct {
+    uint64_t slots[DEVICE_REGISTRY_SLOTS];
+    uint64_t keys[DEVICE_MAX];          // Packed MAC per index, UINT64_MAX when free
+    uint16_t free_list[DEVICE_MAX];     // Stack of free indices
+    int free_count;
+    uint32_t generations[DEVICE_MAX];   // Bumped each time an index is bound
+    uint32_t last_used[DEVICE_MAX];     // 'clock' at the last add or acquire
+    uint32_t clock;
+} device_registry_t;
+
+// An index together with the binding it refers to. State kept per index
+// should store the generation: a different one means the index has since
+// been handed to another MAC and the state is stale. Generation 0 is never
+// used, so zeroed state never matches.
+typedef struct {
+    int index;                          // DEVICE_INDEX_NONE when not registered
+    uint32_t generation;
+} device_ref_t;
+
+void device_registry_init(device_registry_t *reg);
+
+// Index of 'mac', or DEVICE_INDEX_NONE
+int device_registry_find(const device_registry_t *reg, const uint8_t mac[6]);
+// Same for an "aa:bb:cc:dd:ee:ff" string, e.g. from a topic
+int device_registry_find_str(const device_registry_t *reg, const char *mac_str);
+// Index of 'mac', registering it if needed. DEVICE_INDEX_NONE when full.
+int device_registry_add(device_registry_t *reg, const uint8_t mac[6]);
+// Free the index of 'mac' for reuse. Returns the index it had, or DEVICE_INDEX_NONE.
+int device_registry_remove(device_registry_t *reg, const uint8_t mac[6]);
+
+// Reference to 'mac' without registering it or counting it as used
+device_ref_t device_registry_ref(const device_registry_t *reg, const uint8_t mac[6]);
+// Reference to 'mac', registering it if needed. When full, the device added
+// or acquired least recently is removed to make room.
+device_ref_t device_registry_acquire(device_registry_t *reg, const uint8_t mac[6]);
+
+// MAC bound to 'index'; false if the index is free
+bool device_registry_mac(const device_registry_t *reg, int index, uint8_t mac[6]);
+int device_registry_count(const device_registry_t *reg);
+
+#endif // DEVICE_REGISTRY_H
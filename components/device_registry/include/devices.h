@@ -0,0 +1,25 @@
+#ifndef DEVICES_H
+#define DEVICES_H
+
+#include "device_registry.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// The bridge's one device registry. Link stats, wire format state and fleet
+// ownership all index their per-device arrays with these references, so a
+// MAC has the same index in every module. Devices are acquired when a valid
+// frame arrives from them, a frame is sent to them or a fleet summary names
+// them; the least recently acquired one is forgotten when the table is full.
+// Guarded by a spinlock, so safe to call from the Wi-Fi task.
+
+// Reference to 'mac' if registered, without counting it as used
+device_ref_t devices_find(const uint8_t mac[6]);
+// Reference to 'mac', registering it if needed
+device_ref_t devices_acquire(const uint8_t mac[6]);
+// Acquisitions of other devices since 'mac' was last acquired; UINT32_MAX
+// when it is not registered
+uint32_t devices_idle(const uint8_t mac[6]);
+// True while 'device' still refers to the same MAC
+bool devices_current(device_ref_t device);
+
+#endif // DEVICES_H
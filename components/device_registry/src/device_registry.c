@@ -0,0 +1,147 @@
+#include "device_registry.h"
+#include "shared_commands.h"
+#include <string.h>
+
+#define SLOT_MASK       (DEVICE_REGISTRY_SLOTS - 1)
+#define KEY_MASK        0xFFFFFFFFFFFFull
+#define INDEX_SHIFT     48
+#define FREE_KEY        UINT64_MAX
+
+_Static_assert((DEVICE_REGISTRY_SLOTS & SLOT_MASK) == 0, "DEVICE_REGISTRY_SLOTS must be a power of two");
+_Static_assert(DEVICE_REGISTRY_SLOTS > DEVICE_MAX, "registry needs more slots than devices");
+_Static_assert(DEVICE_MAX < 0xFFFF, "device index must fit in 16 bits");
+
+// Fibonacci hashing: vendor prefixes repeat, so mix all 48 bits
+static inline uint32_t home_slot(uint64_t key) {
+    return (uint32_t)((key * 0x9E3779B97F4A7C15ull) >> 32) & SLOT_MASK;
+}
+
+static int find_slot(const device_registry_t *reg, uint64_t key) {
+    for (uint32_t slot = home_slot(key);; slot = (slot + 1) & SLOT_MASK) {
+        uint64_t entry = reg->slots[slot];
+        if (entry == 0) {
+            return -1;
+        }
+        if ((entry & KEY_MASK) == key) {
+            return (int)slot;
+        }
+    }
+}
+
+void device_registry_init(device_registry_t *reg) {
+    memset(reg->slots, 0, sizeof(reg->slots));
+    for (int i = 0; i < DEVICE_MAX; i++) {
+        reg->keys[i] = FREE_KEY;
+        reg->free_list[i] = (uint16_t)(DEVICE_MAX - 1 - i);
+    }
+    reg->free_count = DEVICE_MAX;
+    memset(reg->generations, 0, sizeof(reg->generations));
+    memset(reg->last_used, 0, sizeof(reg->last_used));
+    reg->clock = 0;
+}
+
+int device_registry_find(const device_registry_t *reg, const uint8_t mac[6]) {
+    int slot = find_slot(reg, mac_pack(mac));
+    return slot < 0 ? DEVICE_INDEX_NONE : (int)(reg->slots[slot] >> INDEX_SHIFT) - 1;
+}
+
+int device_registry_find_str(const device_registry_t *reg, const char *mac_str) {
+    uint8_t mac[6];
+    if (!mac_str || !mac_str_to_bytes(mac_str, mac)) {
+        return DEVICE_INDEX_NONE;
+    }
+    return device_registry_find(reg, mac);
+}
+
+int device_registry_add(device_registry_t *reg, const uint8_t mac[6]) {
+    uint64_t key = mac_pack(mac);
+    uint32_t slot = home_slot(key);
+    for (;; slot = (slot + 1) & SLOT_MASK) {
+        uint64_t entry = reg->slots[slot];
+        if (entry == 0) {
+            break;
+        }
+        if ((entry & KEY_MASK) == key) {
+            return (int)(entry >> INDEX_SHIFT) - 1;
+        }
+    }
+    if (reg->free_count == 0) {
+        return DEVICE_INDEX_NONE;
+    }
+
+    int index = reg->free_list[--reg->free_count];
+    reg->keys[index] = key;
+    if (++reg->generations[index] == 0) {
+        reg->generations[index] = 1;
+    }
+    reg->last_used[index] = ++reg->clock;
+    reg->slots[slot] = key | ((uint64_t)(index + 1) << INDEX_SHIFT);
+    return index;
+}
+
+int device_registry_remove(device_registry_t *reg, const uint8_t mac[6]) {
+    int slot = find_slot(reg, mac_pack(mac));
+    if (slot < 0) {
+        return DEVICE_INDEX_NONE;
+    }
+
+    int index = (int)(reg->slots[slot] >> INDEX_SHIFT) - 1;
+    reg->keys[index] = FREE_KEY;
+    reg->free_list[reg->free_count++] = (uint16_t)index;
+
+    // Backward-shift deletion: pull later entries of the probe chain into the
+    // hole so lookups never need tombstones
+    uint32_t hole = (uint32_t)slot;
+    for (uint32_t next = (hole + 1) & SLOT_MASK; reg->slots[next] != 0; next = (next + 1) & SLOT_MASK) {
+        uint32_t home = home_slot(reg->slots[next] & KEY_MASK);
+        // Movable unless its home lies cyclically in (hole, next]
+        if (((next - home) & SLOT_MASK) >= ((next - hole) & SLOT_MASK)) {
+            reg->slots[hole] = reg->slots[next];
+            hole = next;
+        }
+    }
+    reg->slots[hole] = 0;
+    return index;
+}
+
+device_ref_t device_registry_ref(const device_registry_t *reg, const uint8_t mac[6]) {
+    int index = device_registry_find(reg, mac);
+    return (device_ref_t) {
+        .index = index,
+        .generation = index != DEVICE_INDEX_NONE ? reg->generations[index] : 0
+    };
+}
+
+device_ref_t device_registry_acquire(device_registry_t *reg, const uint8_t mac[6]) {
+    int index = device_registry_find(reg, mac);
+    if (index == DEVICE_INDEX_NONE) {
+        if (reg->free_count == 0) {
+            int lru = 0;
+            for (int i = 1; i < DEVICE_MAX; i++) {
+                // Ages rather than timestamps, so a wrapped clock still compares
+                if (reg->clock - reg->last_used[i] > reg->clock - reg->last_used[lru]) {
+                    lru = i;
+                }
+            }
+            uint8_t evicted[6];
+            mac_unpack(reg->keys[lru], evicted);
+            device_registry_remove(reg, evicted);
+        }
+        index = device_registry_add(reg, mac);
+    } else {
+        reg->last_used[index] = ++reg->clock;
+    }
+    return (device_ref_t) { .index = index, .generation = reg->generations[index] };
+}
+
+bool device_registry_mac(const device_registry_t *reg, int index, uint8_t mac[6]) {
+    if (index < 0 || index >= DEVICE_MAX || reg->keys[index] == FREE_KEY) {
+        return false;
+    }
+    mac_unpack(reg->keys[index], mac);
+    return true;
+}
+
+int device_registry_count(const device_registry_t *reg) {
+    return DEVICE_MAX - reg->free_count;
+}
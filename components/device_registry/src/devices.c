@@ -0,0 +1,53 @@
+#include "devices.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdint.h>
+
+static device_registry_t registry;
+static bool registry_ready = false;
+static portMUX_TYPE registry_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Must be called with registry_lock held
+static void ensure_ready(void) {
+    if (!registry_ready) {
+        device_registry_init(&registry);
+        registry_ready = true;
+    }
+}
+
+device_ref_t devices_find(const uint8_t mac[6]) {
+    taskENTER_CRITICAL(&registry_lock);
+    ensure_ready();
+    device_ref_t device = device_registry_ref(&registry, mac);
+    taskEXIT_CRITICAL(&registry_lock);
+    return device;
+}
+
+device_ref_t devices_acquire(const uint8_t mac[6]) {
+    taskENTER_CRITICAL(&registry_lock);
+    ensure_ready();
+    device_ref_t device = device_registry_acquire(&registry, mac);
+    taskEXIT_CRITICAL(&registry_lock);
+    return device;
+}
+
+uint32_t devices_idle(const uint8_t mac[6]) {
+    taskENTER_CRITICAL(&registry_lock);
+    ensure_ready();
+    int index = device_registry_find(&registry, mac);
+    uint32_t idle = index != DEVICE_INDEX_NONE ? registry.clock - registry.last_used[index] : UINT32_MAX;
+    taskEXIT_CRITICAL(&registry_lock);
+    return idle;
+}
+
+bool devices_current(device_ref_t device) {
+    if (device.index < 0 || device.index >= DEVICE_MAX) {
+        return false;
+    }
+    taskENTER_CRITICAL(&registry_lock);
+    ensure_ready();
+    bool current = registry.keys[device.index] != UINT64_MAX &&
+                   registry.generations[device.index] == device.generation;
+    taskEXIT_CRITICAL(&registry_lock);
+    return current;
+}
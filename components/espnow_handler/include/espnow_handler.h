@@ -2,11 +2,46 @@
 #define ESPNOW_HANDLER_H
 
 #include "shared_commands.h"
+#include "link_table.h"
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
-typedef void (*espnow_receive_cb_t)(const uint8_t *mac_addr, const command_packet_t *cmd);
+// 'rssi' is the frame's received signal strength in dBm
+typedef void (*espnow_receive_cb_t)(const uint8_t *mac_addr, const command_packet_t *cmd, int8_t rssi);
+
+// Delivery result of a frame sent with a non-zero token. Runs in the Wi-Fi
+// task, so it must not block.
+typedef void (*espnow_send_result_cb_t)(const uint8_t *mac_addr, uint32_t token, bool delivered);
 
 void espnow_init(espnow_receive_cb_t receive_cb);
 esp_err_t espnow_send(const uint8_t *mac_addr, const command_packet_t *cmd);
+// Like espnow_send, but reports the unicast frame's delivery to the send
+// result callback with 'token'. Broadcast frames are never acknowledged.
+esp_err_t espnow_send_tracked(const uint8_t *mac_addr, const command_packet_t *cmd, uint32_t token);
+void espnow_set_send_result_cb(espnow_send_result_cb_t result_cb);
+
+// Snapshot of the per-peer link table; returns the number of peers copied.
+// 'airtime_us' receives the estimated transmit airtime since boot.
+int espnow_get_link_stats(link_peer_t *peers, int max_peers, uint64_t *airtime_us);
+
+// Wire format used with a device: v1 until it sends a v2 frame, and again
+// after it falls back to v1 (see wire_format.h)
+int espnow_get_wire_version(const uint8_t *mac_addr);
+
+typedef struct {
+    bool active;
+    uint32_t frames;           // Frames captured
+    uint32_t bytes;            // Log size written so far, header included
+    uint32_t dropped;          // Frames lost to a full buffer or the size limit
+} espnow_capture_status_t;
+
+// Log every received and sent frame to 'path' in the format of
+// frame_capture.h until stopped. Frames past 'max_bytes' of log are counted
+// as dropped. Frames are buffered in RAM and written by a background task.
+esp_err_t espnow_capture_start(const char *path, size_t max_bytes);
+// Finish writing and close the log; the status goes inactive once it is closed
+esp_err_t espnow_capture_stop(void);
+void espnow_get_capture_status(espnow_capture_status_t *status);
 
 #endif /* ESPNOW_HANDLER_H */
@@ -0,0 +1,50 @@
+#ifndef FRAME_CAPTURE_H
+#define FRAME_CAPTURE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Capture log layout: an 8-byte file header ("ECAP", version, 3 reserved),
+// then one record per frame:
+//
+//   flags     1 byte   bit 0: direction (0 received, 1 sent)
+//   delta_us  varint   microseconds since the previous record (or capture start)
+//   mac       6 bytes  peer address
+//   rssi      1 byte   signed dBm, 0 for sent frames
+//   len       1 byte
+//   payload   len bytes, the raw ESP-NOW frame
+#define FRAME_CAPTURE_VERSION       1
+#define FRAME_CAPTURE_HEADER_LEN    8
+#define FRAME_CAPTURE_MAX_PAYLOAD   250  // ESP_NOW_MAX_DATA_LEN
+#define FRAME_CAPTURE_MAX_RECORD    (1 + 10 + 6 + 1 + 1 + FRAME_CAPTURE_MAX_PAYLOAD)
+
+typedef enum {
+    CAPTURE_RX = 0,
+    CAPTURE_TX = 1
+} capture_dir_t;
+
+typedef struct {
+    uint64_t timestamp_us;     // Since capture start
+    capture_dir_t direction;
+    uint8_t mac[6];
+    int8_t rssi;
+    uint8_t len;
+    const uint8_t *payload;    // Decoding points into the source buffer
+} capture_record_t;
+
+void frame_capture_write_header(uint8_t out[FRAME_CAPTURE_HEADER_LEN]);
+bool frame_capture_check_header(const uint8_t *data, size_t len);
+
+// Append 'record' to 'out'. '*last_us' carries the previous record's
+// timestamp between calls (0 at capture start) and is only advanced on
+// success. Returns the bytes written, or 0 when the record does not fit.
+size_t frame_capture_encode(const capture_record_t *record, uint64_t *last_us,
+                            uint8_t *out, size_t out_size);
+
+// Read one record from 'data'. Returns the bytes consumed, 0 when the record
+// is cut short (end of a partial log) or -1 when the data is corrupt.
+int frame_capture_decode(const uint8_t *data, size_t len, uint64_t *last_us,
+                         capture_record_t *record);
+
+#endif // FRAME_CAPTURE_H
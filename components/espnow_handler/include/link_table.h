@@ -0,0 +1,77 @@
+#ifndef LINK_TABLE_H
+#define LINK_TABLE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "device_registry.h"
+
+#define LINK_RATE_MARGIN_DB     10   // Fade margin above a rate's sensitivity
+#define LINK_UP_HYSTERESIS_DB   4    // Extra margin before stepping up
+#define LINK_MIN_SENDS          8    // Sends at the current rate before stepping up
+#define LINK_UP_SUCCESS_PCT     90
+#define LINK_DOWN_SUCCESS_PCT   70
+#define LINK_DOWN_FAIL_STREAK   3
+#define LINK_WINDOW_SENDS       32   // Success counters are halved at this size
+
+// PHY rate ladder, slowest first
+typedef enum {
+    LINK_RATE_1M = 0,
+    LINK_RATE_2M,
+    LINK_RATE_5M5,
+    LINK_RATE_11M,
+    LINK_RATE_12M,
+    LINK_RATE_24M,
+    LINK_RATE_54M,
+    LINK_RATE_COUNT
+} link_rate_t;
+
+typedef struct {
+    bool used;
+    uint8_t mac[6];
+    uint32_t generation;       // Of the device reference the peer was created for
+
+    bool rssi_valid;
+    int16_t rssi_avg_x16;      // EWMA of received RSSI, 1/16 dB units
+    uint32_t rx_frames;
+
+    uint32_t tx_frames;
+    uint32_t tx_ok;
+    uint32_t tx_fail;
+    uint16_t fail_streak;      // Consecutive failed sends
+    uint16_t max_fail_streak;
+    uint16_t window_sent;      // Decaying window at the current rate
+    uint16_t window_ok;
+    uint64_t airtime_us;
+
+    link_rate_t rate;          // Selected rate
+    link_rate_t applied_rate;  // Rate last configured in ESP-NOW, LINK_RATE_COUNT if none
+} link_peer_t;
+
+// Indexed by device registry index. Plain data without locking; the owner
+// serializes access.
+typedef struct {
+    link_peer_t peers[DEVICE_MAX];
+    uint64_t airtime_us;       // Estimated transmit airtime over all peers
+} link_table_t;
+
+void link_table_init(link_table_t *table);
+
+// Peer state of 'device', optionally creating it for 'mac'. State left by an
+// earlier holder of the same index is discarded.
+link_peer_t* link_table_get(link_table_t *table, device_ref_t device, const uint8_t mac[6],
+                            bool create);
+
+void link_table_on_rx(link_peer_t *peer, int8_t rssi);
+// Account a frame of 'len' payload bytes about to be sent at the peer's rate
+void link_table_on_tx(link_table_t *table, link_peer_t *peer, size_t len);
+void link_table_on_tx_done(link_peer_t *peer, bool success);
+
+int link_peer_rssi(const link_peer_t *peer);
+int link_peer_success_pct(const link_peer_t *peer);
+
+const char* link_rate_name(link_rate_t rate);
+// Estimated on-air time of an ESP-NOW frame with 'len' payload bytes
+uint32_t link_rate_airtime_us(link_rate_t rate, size_t len);
+
+#endif // LINK_TABLE_H
@@ -1,24 +1,232 @@
 #include "espnow_handler.h"
+#include "frame_capture.h"
 #include "shared_commands.h"
+#include "wire_format.h"
+#include "devices.h"
 #include "esp_log.h"
 #include "esp_now.h"
 #include "esp_wifi.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <inttypes.h>
+#include <stdio.h>
 #include <string.h>
 
 #define TAG "ESPNOW"
 
+#define CAPTURE_RING_SIZE       4096  // Records waiting for the writer task
+#define CAPTURE_FLUSH_MS        500
+#define CAPTURE_TASK_STACK      3072
+#define CAPTURE_TASK_PRIORITY   2
+
+#define WIRE_TX_RING            4     // Sends per device remembered until their callback
+
 static espnow_receive_cb_t receive_callback = NULL;
+static espnow_send_result_cb_t send_result_callback = NULL;
+
+// Touched from the Wi-Fi task (callbacks) and from senders
+static link_table_t links;
+static portMUX_TYPE link_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static const wifi_phy_rate_t phy_rates[LINK_RATE_COUNT] = {
+    [LINK_RATE_1M]  = WIFI_PHY_RATE_1M_L,
+    [LINK_RATE_2M]  = WIFI_PHY_RATE_2M_S,
+    [LINK_RATE_5M5] = WIFI_PHY_RATE_5M_S,
+    [LINK_RATE_11M] = WIFI_PHY_RATE_11M_S,
+    [LINK_RATE_12M] = WIFI_PHY_RATE_12M,
+    [LINK_RATE_24M] = WIFI_PHY_RATE_24M,
+    [LINK_RATE_54M] = WIFI_PHY_RATE_54M,
+};
+
+// Frames are encoded into a ring from the Wi-Fi task and senders; the writer
+// task moves them to the log file, so callbacks never wait on flash
+static struct {
+    bool active;
+    bool stop_requested;       // Set by any task, cleared on start; under capture_lock
+    FILE *file;
+    size_t max_bytes;
+    int64_t start_us;
+    uint64_t last_us;
+    uint8_t ring[CAPTURE_RING_SIZE];
+    size_t head;               // Next byte to write
+    size_t used;
+    espnow_capture_status_t status;
+} capture;
+static portMUX_TYPE capture_lock = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t capture_task_handle = NULL;
+
+// A frame handed to ESP-NOW, settled by its own send callback
+typedef struct {
+    uint32_t seq;
+    uint32_t token;            // Caller's reference for the send result, 0 if none
+    bool sets_time;            // SYNC or SYNC response carrying 'time'
+    time_t time;
+} wire_tx_t;
+
+// Wire format spoken by each device, indexed like the link table by the
+// shared device registry. Send callbacks arrive in send order, so the n-th
+// callback for a device is its n-th send; with more than WIRE_TX_RING in
+// flight the oldest entries are overwritten and their callbacks settle nothing.
+typedef struct {
+    uint32_t generation;       // Of the device reference, 0 = unused
+    uint8_t version;           // Of the last valid frame received
+    wire_time_base_t base;     // Last time setting the device acknowledged
+    uint32_t tx_queued;        // Frames handed to ESP-NOW
+    uint32_t tx_done;          // Send callbacks seen
+    wire_tx_t tx[WIRE_TX_RING];
+} wire_peer_t;
+
+static wire_peer_t wire_peers[DEVICE_MAX];
+static portMUX_TYPE wire_lock = portMUX_INITIALIZER_UNLOCKED;
+// Keeps a device's sequence numbers in step with its frames across senders
+static SemaphoreHandle_t send_lock = NULL;
+
+static bool is_broadcast(const uint8_t *mac_addr) {
+    static const uint8_t broadcast[ESP_NOW_ETH_ALEN] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+    return memcmp(mac_addr, broadcast, ESP_NOW_ETH_ALEN) == 0;
+}
+
+static void capture_frame(capture_dir_t direction, const uint8_t *mac_addr, int8_t rssi,
+                          const uint8_t *data, size_t len) {
+    if (!capture.active || len > FRAME_CAPTURE_MAX_PAYLOAD) {
+        return;
+    }
+
+    uint8_t record[FRAME_CAPTURE_MAX_RECORD];
+    capture_record_t entry = {
+        .direction = direction,
+        .rssi = rssi,
+        .len = (uint8_t)len,
+        .payload = data
+    };
+    memcpy(entry.mac, mac_addr, 6);
+
+    taskENTER_CRITICAL(&capture_lock);
+    if (capture.active) {
+        entry.timestamp_us = (uint64_t)(esp_timer_get_time() - capture.start_us);
+        uint64_t last_us = capture.last_us;
+        size_t size = frame_capture_encode(&entry, &last_us, record, sizeof(record));
+        bool fits = size > 0 && capture.used + size <= CAPTURE_RING_SIZE &&
+                    capture.status.bytes + capture.used + size <= capture.max_bytes;
+        if (fits) {
+            size_t first = CAPTURE_RING_SIZE - capture.head;
+            first = size < first ? size : first;
+            memcpy(&capture.ring[capture.head], record, first);
+            memcpy(capture.ring, &record[first], size - first);
+            capture.head = (capture.head + size) % CAPTURE_RING_SIZE;
+            capture.used += size;
+            capture.last_us = last_us;
+            capture.status.frames++;
+        } else {
+            capture.status.dropped++;
+        }
+    }
+    taskEXIT_CRITICAL(&capture_lock);
+}
+
+// Must be called with wire_lock held. Existing state for 'device', or NULL.
+static wire_peer_t* wire_peer_find(device_ref_t device) {
+    if (device.index == DEVICE_INDEX_NONE || wire_peers[device.index].generation != device.generation) {
+        return NULL;
+    }
+    return &wire_peers[device.index];
+}
+
+// Must be called with wire_lock held. State for 'device', starting over at
+// v1 if its index last belonged to another MAC.
+static wire_peer_t* wire_peer_get(device_ref_t device) {
+    if (device.index == DEVICE_INDEX_NONE) {
+        return NULL;
+    }
+    wire_peer_t *peer = &wire_peers[device.index];
+    if (peer->generation != device.generation) {
+        *peer = (wire_peer_t) { .generation = device.generation, .version = WIRE_VERSION_V1 };
+    }
+    return peer;
+}
+
+// Turn a v2 frame into the v1 packet in 'out'; returns its length, 0 to drop.
+// Unknown senders are not registered here: the frame is not validated yet.
+static int wire_receive_v2(const uint8_t *mac_addr, const uint8_t *data, int len,
+                           uint8_t *out, size_t out_size) {
+    wire_time_base_t base = {0};
+    device_ref_t device = devices_find(mac_addr);
+    taskENTER_CRITICAL(&wire_lock);
+    wire_peer_t *peer = wire_peer_find(device);
+    if (peer) {
+        base = peer->base;
+    }
+    taskEXIT_CRITICAL(&wire_lock);
+
+    size_t out_len = 0;
+    esp_err_t err = wire_decode_v2(data, len, &base, (command_packet_t *)out, out_size, &out_len);
+    if (err == ESP_ERR_INVALID_STATE) {
+        ESP_LOGW(TAG, "Dropped v2 frame timed against an unknown SYNC; the device needs a new SYNC");
+        return 0;
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Received malformed v2 frame of %d bytes", len);
+        return 0;
+    }
+    return (int)out_len;
+}
+
+// Called for valid frames only
+static void wire_note_version(device_ref_t device, const uint8_t *mac_addr, int version) {
+    taskENTER_CRITICAL(&wire_lock);
+    wire_peer_t *peer = wire_peer_get(device);
+    bool changed = peer && peer->version != version;
+    if (changed) {
+        peer->version = version;
+    }
+    taskEXIT_CRITICAL(&wire_lock);
+
+    if (changed) {
+        char mac_str[MAC_STR_LEN];
+        mac_bytes_to_str(mac_addr, mac_str);
+        ESP_LOGI(TAG, "%s now speaks wire format v%d", mac_str, version);
+    }
+}
 
 static void espnow_recv_cb(const esp_now_recv_info_t *info, const uint8_t *data, int len) {
-    if (receive_callback && info && info->src_addr && data && len >= sizeof(command_packet_t)) {
+    // Captured before validation so replays see malformed traffic too
+    if (info && info->src_addr && data && len > 0) {
+        capture_frame(CAPTURE_RX, info->src_addr, info->rx_ctrl ? info->rx_ctrl->rssi : 0, data, len);
+    }
+
+    uint8_t decoded[sizeof(command_packet_t) + UINT8_MAX];
+    int version = info && info->src_addr && data ? wire_frame_version(data, len) : 0;
+    if (version == WIRE_VERSION_V2) {
+        len = wire_receive_v2(info->src_addr, data, len, decoded, sizeof(decoded));
+        if (len == 0) {
+            return;
+        }
+        data = decoded;
+    } else if (version > WIRE_VERSION_V2) {
+        ESP_LOGW(TAG, "Ignoring frame in unsupported wire format v%d", version);
+        return;
+    }
+
+    if (receive_callback && info && info->src_addr && data && len >= (int)sizeof(command_packet_t)) {
         command_packet_t* cmd = (command_packet_t*)data;
         
         // Validate data length
-        if (len >= sizeof(command_packet_t) + cmd->data_len) {
-            receive_callback(info->src_addr, cmd);
+        if (command_packet_validate(data, len)) {
+            int8_t rssi = info->rx_ctrl ? info->rx_ctrl->rssi : 0;
+            device_ref_t device = devices_acquire(info->src_addr);
+            wire_note_version(device, info->src_addr, version);
+            if (info->rx_ctrl && device.index != DEVICE_INDEX_NONE) {
+                taskENTER_CRITICAL(&link_lock);
+                link_peer_t *peer = link_table_get(&links, device, info->src_addr, true);
+                link_table_on_rx(peer, rssi);
+                taskEXIT_CRITICAL(&link_lock);
+            }
+            receive_callback(info->src_addr, cmd, rssi);
         } else {
             ESP_LOGE(TAG, "Received invalid data length: %d, expected at least: %d", 
-                    len, sizeof(command_packet_t) + cmd->data_len);
+                    len, (int)(sizeof(command_packet_t) + cmd->data_len));
         }
     } else {
         ESP_LOGE(TAG, "Received invalid ESPNOW message");
@@ -27,11 +235,170 @@ static void espnow_recv_cb(const esp_now_recv_info_t *info, const uint8_t *data,
 
 static void espnow_send_cb(const uint8_t *mac_addr, esp_now_send_status_t status) {
     ESP_LOGD(TAG, "Send status: %s", status == ESP_NOW_SEND_SUCCESS ? "Success" : "Fail");
+    if (mac_addr == NULL || is_broadcast(mac_addr)) {
+        return;
+    }
+
+    device_ref_t device = devices_find(mac_addr);
+    taskENTER_CRITICAL(&link_lock);
+    link_peer_t *peer = link_table_get(&links, device, mac_addr, false);
+    if (peer) {
+        link_table_on_tx_done(peer, status == ESP_NOW_SEND_SUCCESS);
+    }
+    taskEXIT_CRITICAL(&link_lock);
+
+    // A time setting becomes the base once its own frame is acknowledged
+    uint32_t token = 0;
+    taskENTER_CRITICAL(&wire_lock);
+    wire_peer_t *wire = wire_peer_find(device);
+    if (wire && wire->tx_done != wire->tx_queued) {
+        uint32_t seq = wire->tx_done++;
+        const wire_tx_t *tx = &wire->tx[seq % WIRE_TX_RING];
+        if (tx->seq == seq) {
+            token = tx->token;
+            if (tx->sets_time && status == ESP_NOW_SEND_SUCCESS) {
+                wire->base = (wire_time_base_t) { .valid = true, .time = tx->time };
+            }
+        }
+    }
+    taskEXIT_CRITICAL(&wire_lock);
+
+    if (token != 0 && send_result_callback) {
+        send_result_callback(mac_addr, token, status == ESP_NOW_SEND_SUCCESS);
+    }
+}
+
+// Time a frame sets on the device, if it is a SYNC or SYNC response
+static bool time_setting(const command_packet_t *cmd, time_t *t) {
+    if (cmd->command == CMD_SYNC && cmd->data_len == sizeof(sync_data_t)) {
+        sync_data_t sync;
+        memcpy(&sync, cmd->data, sizeof(sync));
+        *t = sync.device_time;
+        return true;
+    }
+    if (cmd->command == (CMD_SYNC | CMD_RESPONSE) && cmd->data_len == sizeof(sync_response_t)) {
+        sync_response_t reply;
+        memcpy(&reply, cmd->data, sizeof(reply));
+        *t = reply.master_time;
+        return true;
+    }
+    return false;
+}
+
+// Must be called with send_lock held, for unicast frames only. Queues 'cmd'
+// for its send callback, which can run before esp_now_send returns, and
+// encodes it the way the device expects; returns the frame to send.
+static const uint8_t* wire_prepare(device_ref_t device, const command_packet_t *cmd,
+                                   uint32_t token, uint8_t *frame, size_t *size) {
+    wire_tx_t tx = { .token = token };
+    tx.sets_time = time_setting(cmd, &tx.time);
+
+    taskENTER_CRITICAL(&wire_lock);
+    wire_peer_t *peer = wire_peer_get(device);
+    int version = peer ? peer->version : WIRE_VERSION_V1;
+    wire_time_base_t base = peer ? peer->base : (wire_time_base_t) {0};
+    if (peer) {
+        tx.seq = peer->tx_queued++;
+        peer->tx[tx.seq % WIRE_TX_RING] = tx;
+    }
+    taskEXIT_CRITICAL(&wire_lock);
+
+    if (version == WIRE_VERSION_V2) {
+        size_t len = wire_encode_v2(cmd, &base, frame, WIRE_MAX_FRAME);
+        if (len > 0) {
+            *size = len;
+            return frame;
+        }
+    }
+    return (const uint8_t *)cmd;
+}
+
+// Must be called with send_lock held: no callback will come for the frame
+// wire_prepare queued last
+static void wire_unprepare(device_ref_t device) {
+    taskENTER_CRITICAL(&wire_lock);
+    wire_peer_t *peer = wire_peer_find(device);
+    if (peer && peer->tx_queued != peer->tx_done) {
+        peer->tx_queued--;
+    }
+    taskEXIT_CRITICAL(&wire_lock);
+}
+
+// Unicast frames need a registered peer; when the peer list is full, drop
+// the one whose device was used least recently
+static esp_err_t ensure_peer(const uint8_t *mac_addr) {
+    if (esp_now_is_peer_exist(mac_addr)) {
+        return ESP_OK;
+    }
+
+    esp_now_peer_info_t peer = {0};
+    memcpy(peer.peer_addr, mac_addr, ESP_NOW_ETH_ALEN);
+    peer.channel = 0;
+    peer.ifidx = ESP_IF_WIFI_AP;
+    peer.encrypt = false;
+
+    esp_err_t err = esp_now_add_peer(&peer);
+    if (err != ESP_ERR_ESPNOW_FULL) {
+        return err;
+    }
+
+    esp_now_peer_info_t candidate = {0};
+    uint8_t victim[ESP_NOW_ETH_ALEN];
+    uint32_t victim_idle = 0;
+    bool found = false;
+    for (esp_err_t ret = esp_now_fetch_peer(true, &candidate); ret == ESP_OK;
+         ret = esp_now_fetch_peer(false, &candidate)) {
+        if (is_broadcast(candidate.peer_addr)) {
+            continue;
+        }
+        // Forgotten devices count as idle the longest
+        uint32_t idle = devices_idle(candidate.peer_addr);
+        if (!found || idle > victim_idle) {
+            memcpy(victim, candidate.peer_addr, ESP_NOW_ETH_ALEN);
+            victim_idle = idle;
+            found = true;
+        }
+    }
+    if (!found) {
+        return err;
+    }
+
+    esp_now_del_peer(victim);
+    return esp_now_add_peer(&peer);
+}
+
+static void apply_rate(const uint8_t *mac_addr, link_rate_t rate) {
+    esp_now_rate_config_t config = {
+        .phymode = rate <= LINK_RATE_11M ? WIFI_PHY_MODE_11B : WIFI_PHY_MODE_11G,
+        .rate = phy_rates[rate],
+        .ersu = false,
+        .dcm = false
+    };
+
+    esp_err_t err = esp_now_set_peer_rate_config(mac_addr, &config);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to set rate %s: %s", link_rate_name(rate), esp_err_to_name(err));
+        return;
+    }
+
+    device_ref_t device = devices_find(mac_addr);
+    taskENTER_CRITICAL(&link_lock);
+    link_peer_t *peer = link_table_get(&links, device, mac_addr, false);
+    if (peer) {
+        peer->applied_rate = rate;
+    }
+    taskEXIT_CRITICAL(&link_lock);
+    ESP_LOGI(TAG, "Peer rate now %s", link_rate_name(rate));
 }
 
 void espnow_init(espnow_receive_cb_t receive_cb) {
     // Store callback even if it's NULL
     receive_callback = receive_cb;
+    link_table_init(&links);
+    if (send_lock == NULL) {
+        send_lock = xSemaphoreCreateMutex();
+        ESP_ERROR_CHECK(send_lock ? ESP_OK : ESP_ERR_NO_MEM);
+    }
     
     // De-init ESP-NOW first in case it was already initialized
     esp_now_deinit();
@@ -60,7 +427,15 @@ void espnow_init(espnow_receive_cb_t receive_cb) {
     ESP_LOGI(TAG, "ESP-NOW initialized successfully");
 }
 
+void espnow_set_send_result_cb(espnow_send_result_cb_t result_cb) {
+    send_result_callback = result_cb;
+}
+
 esp_err_t espnow_send(const uint8_t *mac_addr, const command_packet_t *cmd) {
+    return espnow_send_tracked(mac_addr, cmd, 0);
+}
+
+esp_err_t espnow_send_tracked(const uint8_t *mac_addr, const command_packet_t *cmd, uint32_t token) {
     if (mac_addr == NULL || cmd == NULL) {
         ESP_LOGE(TAG, "Invalid parameters for espnow_send");
         return ESP_ERR_INVALID_ARG;
@@ -68,20 +443,206 @@ esp_err_t espnow_send(const uint8_t *mac_addr, const command_packet_t *cmd) {
     
     // Calculate total size
     size_t total_size = sizeof(command_packet_t) + cmd->data_len;
+    const uint8_t *frame = (const uint8_t *)cmd;
+    uint8_t encoded[WIRE_MAX_FRAME];
     
     // Log sending information
-    char mac_str[18];
-    snprintf(mac_str, sizeof(mac_str), "%02x:%02x:%02x:%02x:%02x:%02x",
-             mac_addr[0], mac_addr[1], mac_addr[2],
-             mac_addr[3], mac_addr[4], mac_addr[5]);
+    char mac_str[MAC_STR_LEN];
+    mac_bytes_to_str(mac_addr, mac_str);
     ESP_LOGI(TAG, "Sending command %d to %s, data size: %u", 
              cmd->command, mac_str, cmd->data_len);
     
+    bool unicast = !is_broadcast(mac_addr);
+    device_ref_t device = { .index = DEVICE_INDEX_NONE };
+    xSemaphoreTake(send_lock, portMAX_DELAY);
+    if (unicast) {
+        esp_err_t err = ensure_peer(mac_addr);
+        if (err != ESP_OK) {
+            xSemaphoreGive(send_lock);
+            ESP_LOGE(TAG, "Failed to register peer %s: %s", mac_str, esp_err_to_name(err));
+            return err;
+        }
+
+        device = devices_acquire(mac_addr);
+        frame = wire_prepare(device, cmd, token, encoded, &total_size);
+
+        taskENTER_CRITICAL(&link_lock);
+        link_peer_t *peer = link_table_get(&links, device, mac_addr, true);
+        link_rate_t rate = LINK_RATE_1M;
+        bool rate_changed = false;
+        if (peer) {
+            link_table_on_tx(&links, peer, total_size);
+            rate = peer->rate;
+            rate_changed = peer->rate != peer->applied_rate;
+        }
+        taskEXIT_CRITICAL(&link_lock);
+
+        if (rate_changed) {
+            apply_rate(mac_addr, rate);
+        }
+    }
+
     // Send the command
-    esp_err_t err = esp_now_send(mac_addr, (uint8_t *)cmd, total_size);
+    esp_err_t err = esp_now_send(mac_addr, frame, total_size);
+    if (err != ESP_OK && unicast) {
+        wire_unprepare(device);
+    }
+    xSemaphoreGive(send_lock);
+
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "Failed to send ESP-NOW message: %s", esp_err_to_name(err));
+    } else {
+        capture_frame(CAPTURE_TX, mac_addr, 0, frame, total_size);
     }
     
     return err;
 }
+
+int espnow_get_link_stats(link_peer_t *peers, int max_peers, uint64_t *airtime_us) {
+    int count = 0;
+
+    taskENTER_CRITICAL(&link_lock);
+    for (int i = 0; i < DEVICE_MAX && count < max_peers; i++) {
+        if (links.peers[i].used) {
+            peers[count++] = links.peers[i];
+        }
+    }
+    if (airtime_us) {
+        *airtime_us = links.airtime_us;
+    }
+    taskEXIT_CRITICAL(&link_lock);
+    return count;
+}
+
+int espnow_get_wire_version(const uint8_t *mac_addr) {
+    device_ref_t device = devices_find(mac_addr);
+    taskENTER_CRITICAL(&wire_lock);
+    const wire_peer_t *peer = wire_peer_find(device);
+    int version = peer ? peer->version : WIRE_VERSION_V1;
+    taskEXIT_CRITICAL(&wire_lock);
+    return version;
+}
+
+// Move everything queued so far to the log file
+static void capture_flush(void) {
+    static uint8_t chunk[CAPTURE_RING_SIZE];
+
+    taskENTER_CRITICAL(&capture_lock);
+    size_t tail = (capture.head + CAPTURE_RING_SIZE - capture.used) % CAPTURE_RING_SIZE;
+    size_t len = capture.used;
+    size_t first = CAPTURE_RING_SIZE - tail;
+    first = len < first ? len : first;
+    memcpy(chunk, &capture.ring[tail], first);
+    memcpy(&chunk[first], capture.ring, len - first);
+    capture.used = 0;
+    taskEXIT_CRITICAL(&capture_lock);
+
+    if (len == 0) {
+        return;
+    }
+    size_t written = fwrite(chunk, 1, len, capture.file);
+    fflush(capture.file);
+
+    taskENTER_CRITICAL(&capture_lock);
+    capture.status.bytes += written;
+    if (written != len) {
+        capture.stop_requested = true;
+    }
+    taskEXIT_CRITICAL(&capture_lock);
+    if (written != len) {
+        ESP_LOGE(TAG, "Capture log write failed, stopping capture");
+    }
+}
+
+static void capture_task(void *arg) {
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(CAPTURE_FLUSH_MS));
+        if (capture.file == NULL) {
+            continue;
+        }
+
+        capture_flush();
+        taskENTER_CRITICAL(&capture_lock);
+        bool stop = capture.stop_requested;
+        if (stop) {
+            capture.active = false;
+            capture.status.active = false;
+        }
+        taskEXIT_CRITICAL(&capture_lock);
+        if (stop) {
+            // Anything queued since the flush above
+            capture_flush();
+            fclose(capture.file);
+            taskENTER_CRITICAL(&capture_lock);
+            capture.file = NULL;
+            taskEXIT_CRITICAL(&capture_lock);
+            ESP_LOGI(TAG, "Capture stopped: %" PRIu32 " frames, %" PRIu32 " bytes, %" PRIu32 " dropped",
+                     capture.status.frames, capture.status.bytes, capture.status.dropped);
+        }
+    }
+}
+
+esp_err_t espnow_capture_start(const char *path, size_t max_bytes) {
+    if (path == NULL || max_bytes <= FRAME_CAPTURE_HEADER_LEN) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (capture.file != NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (capture_task_handle == NULL &&
+        xTaskCreate(capture_task, "espnow_capture", CAPTURE_TASK_STACK, NULL,
+                    CAPTURE_TASK_PRIORITY, &capture_task_handle) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    FILE *file = fopen(path, "wb");
+    if (file == NULL) {
+        ESP_LOGE(TAG, "Failed to open capture log %s", path);
+        return ESP_FAIL;
+    }
+    uint8_t header[FRAME_CAPTURE_HEADER_LEN];
+    frame_capture_write_header(header);
+    if (fwrite(header, 1, sizeof(header), file) != sizeof(header)) {
+        fclose(file);
+        return ESP_FAIL;
+    }
+
+    taskENTER_CRITICAL(&capture_lock);
+    capture.file = file;
+    capture.max_bytes = max_bytes;
+    capture.start_us = esp_timer_get_time();
+    capture.last_us = 0;
+    capture.head = 0;
+    capture.used = 0;
+    capture.stop_requested = false;
+    capture.status = (espnow_capture_status_t) {
+        .active = true,
+        .bytes = FRAME_CAPTURE_HEADER_LEN
+    };
+    capture.active = true;
+    taskEXIT_CRITICAL(&capture_lock);
+
+    ESP_LOGI(TAG, "Capturing frames to %s (up to %u bytes)", path, (unsigned)max_bytes);
+    return ESP_OK;
+}
+
+esp_err_t espnow_capture_stop(void) {
+    taskENTER_CRITICAL(&capture_lock);
+    bool running = capture.file != NULL && !capture.stop_requested;
+    if (running) {
+        capture.stop_requested = true;
+    }
+    taskEXIT_CRITICAL(&capture_lock);
+    if (!running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xTaskNotifyGive(capture_task_handle);
+    return ESP_OK;
+}
+
+void espnow_get_capture_status(espnow_capture_status_t *status) {
+    taskENTER_CRITICAL(&capture_lock);
+    *status = capture.status;
+    taskEXIT_CRITICAL(&capture_lock);
+}
@@ -0,0 +1,75 @@
+#include "frame_capture.h"
+#include "shared_commands.h"
+#include <string.h>
+
+static const uint8_t magic[4] = {'E', 'C', 'A', 'P'};
+
+#define FLAG_TX         0x01
+#define FLAGS_KNOWN     FLAG_TX
+
+void frame_capture_write_header(uint8_t out[FRAME_CAPTURE_HEADER_LEN]) {
+    memset(out, 0, FRAME_CAPTURE_HEADER_LEN);
+    memcpy(out, magic, sizeof(magic));
+    out[4] = FRAME_CAPTURE_VERSION;
+}
+
+bool frame_capture_check_header(const uint8_t *data, size_t len) {
+    return len >= FRAME_CAPTURE_HEADER_LEN && memcmp(data, magic, sizeof(magic)) == 0 &&
+           data[4] == FRAME_CAPTURE_VERSION;
+}
+
+size_t frame_capture_encode(const capture_record_t *record, uint64_t *last_us,
+                            uint8_t *out, size_t out_size) {
+    if (out_size < 1 || record->timestamp_us < *last_us) {
+        return 0;
+    }
+
+    out[0] = record->direction == CAPTURE_TX ? FLAG_TX : 0;
+    size_t pos = 1;
+    size_t n = varint_encode(record->timestamp_us - *last_us, out + pos, out_size - pos);
+    if (n == 0) {
+        return 0;
+    }
+    pos += n;
+    if (out_size - pos < 8u + record->len) {
+        return 0;
+    }
+
+    memcpy(out + pos, record->mac, 6);
+    out[pos + 6] = (uint8_t)record->rssi;
+    out[pos + 7] = record->len;
+    memcpy(out + pos + 8, record->payload, record->len);
+    *last_us = record->timestamp_us;
+    return pos + 8 + record->len;
+}
+
+int frame_capture_decode(const uint8_t *data, size_t len, uint64_t *last_us,
+                         capture_record_t *record) {
+    if (len < 1) {
+        return 0;
+    }
+    if (data[0] & ~FLAGS_KNOWN) {
+        return -1;
+    }
+
+    uint64_t delta;
+    size_t pos = 1;
+    size_t n = varint_decode(data + pos, len - pos, &delta);
+    if (n == 0) {
+        // Either cut short or an over-long varint
+        return len - pos >= VARINT_MAX_LEN ? -1 : 0;
+    }
+    pos += n;
+    if (len - pos < 8 || len - pos - 8 < data[pos + 7]) {
+        return 0;
+    }
+
+    record->timestamp_us = *last_us + delta;
+    record->direction = (data[0] & FLAG_TX) ? CAPTURE_TX : CAPTURE_RX;
+    memcpy(record->mac, data + pos, 6);
+    record->rssi = (int8_t)data[pos + 6];
+    record->len = data[pos + 7];
+    record->payload = data + pos + 8;
+    *last_us = record->timestamp_us;
+    return (int)(pos + 8 + record->len);
+}
@@ -0,0 +1,174 @@
+#include "link_table.h"
+#include <string.h>
+
+// 802.11 header, vendor action body and FCS around the ESP-NOW payload
+#define ESPNOW_FRAME_OVERHEAD 43
+
+typedef struct {
+    int sensitivity_dbm;       // Typical receiver sensitivity at 250 bytes
+    uint16_t mbps_x10;
+    bool ofdm;
+    const char *name;
+} rate_info_t;
+
+static const rate_info_t rates[LINK_RATE_COUNT] = {
+    [LINK_RATE_1M]  = {-98, 10,  false, "1M"},
+    [LINK_RATE_2M]  = {-95, 20,  false, "2M"},
+    [LINK_RATE_5M5] = {-92, 55,  false, "5.5M"},
+    [LINK_RATE_11M] = {-88, 110, false, "11M"},
+    [LINK_RATE_12M] = {-87, 120, true,  "12M"},
+    [LINK_RATE_24M] = {-83, 240, true,  "24M"},
+    [LINK_RATE_54M] = {-75, 540, true,  "54M"},
+};
+
+void link_table_init(link_table_t *table) {
+    memset(table, 0, sizeof(*table));
+}
+
+link_peer_t* link_table_get(link_table_t *table, device_ref_t device, const uint8_t mac[6],
+                            bool create) {
+    if (device.index < 0 || device.index >= DEVICE_MAX) {
+        return NULL;
+    }
+
+    link_peer_t *peer = &table->peers[device.index];
+    if (peer->used && peer->generation == device.generation) {
+        return peer;
+    }
+    if (!create) {
+        return NULL;
+    }
+
+    memset(peer, 0, sizeof(*peer));
+    peer->used = true;
+    memcpy(peer->mac, mac, 6);
+    peer->generation = device.generation;
+    peer->rate = LINK_RATE_1M;
+    peer->applied_rate = LINK_RATE_COUNT;   // Unknown: configure on the first send
+    return peer;
+}
+
+int link_peer_rssi(const link_peer_t *peer) {
+    int avg = peer->rssi_avg_x16;
+    return (avg + (avg < 0 ? -8 : 8)) / 16;
+}
+
+int link_peer_success_pct(const link_peer_t *peer) {
+    return peer->window_sent ? peer->window_ok * 100 / peer->window_sent : 100;
+}
+
+// Fastest rate whose sensitivity clears 'rssi' by the fade margin plus 'extra_db'
+static link_rate_t rate_for_rssi(int rssi, int extra_db) {
+    link_rate_t best = LINK_RATE_1M;
+    for (int r = 0; r < LINK_RATE_COUNT; r++) {
+        if (rssi >= rates[r].sensitivity_dbm + LINK_RATE_MARGIN_DB + extra_db) {
+            best = r;
+        }
+    }
+    return best;
+}
+
+static void set_rate(link_peer_t *peer, link_rate_t rate) {
+    peer->rate = rate;
+    peer->window_sent = 0;
+    peer->window_ok = 0;
+    peer->fail_streak = 0;
+}
+
+// Step down at once on a weak or failing link; step up one rate at a time,
+// and only after the current rate has proven itself with margin to spare
+static void adapt(link_peer_t *peer) {
+    if (!peer->rssi_valid) {
+        return;
+    }
+
+    int rssi = link_peer_rssi(peer);
+    link_rate_t current = peer->rate;
+
+    bool weak = rssi < rates[current].sensitivity_dbm + LINK_RATE_MARGIN_DB;
+    bool failing = peer->fail_streak >= LINK_DOWN_FAIL_STREAK ||
+                   (peer->window_sent >= LINK_MIN_SENDS &&
+                    link_peer_success_pct(peer) < LINK_DOWN_SUCCESS_PCT);
+    if (current > LINK_RATE_1M && (weak || failing)) {
+        link_rate_t lower = current - 1;
+        if (weak && rate_for_rssi(rssi, 0) < lower) {
+            lower = rate_for_rssi(rssi, 0);
+        }
+        set_rate(peer, lower);
+        return;
+    }
+
+    if (current + 1 < LINK_RATE_COUNT &&
+        rssi >= rates[current + 1].sensitivity_dbm + LINK_RATE_MARGIN_DB + LINK_UP_HYSTERESIS_DB &&
+        peer->window_sent >= LINK_MIN_SENDS &&
+        link_peer_success_pct(peer) >= LINK_UP_SUCCESS_PCT) {
+        set_rate(peer, current + 1);
+    }
+}
+
+void link_table_on_rx(link_peer_t *peer, int8_t rssi) {
+    if (peer->rssi_valid) {
+        peer->rssi_avg_x16 += (rssi * 16 - peer->rssi_avg_x16) / 8;
+    } else {
+        peer->rssi_avg_x16 = rssi * 16;
+        peer->rssi_valid = true;
+    }
+    peer->rx_frames++;
+
+    if (peer->tx_frames == 0) {
+        // Nothing sent yet, so there is no history to protect: start from the RSSI
+        peer->rate = rate_for_rssi(link_peer_rssi(peer), LINK_UP_HYSTERESIS_DB);
+    } else {
+        adapt(peer);
+    }
+}
+
+void link_table_on_tx(link_table_t *table, link_peer_t *peer, size_t len) {
+    uint32_t airtime = link_rate_airtime_us(peer->rate, len);
+    peer->tx_frames++;
+    peer->airtime_us += airtime;
+    table->airtime_us += airtime;
+}
+
+void link_table_on_tx_done(link_peer_t *peer, bool success) {
+    if (success) {
+        peer->tx_ok++;
+        peer->window_ok++;
+        peer->fail_streak = 0;
+    } else {
+        peer->tx_fail++;
+        peer->fail_streak++;
+        if (peer->fail_streak > peer->max_fail_streak) {
+            peer->max_fail_streak = peer->fail_streak;
+        }
+    }
+
+    if (++peer->window_sent >= LINK_WINDOW_SENDS) {
+        peer->window_sent /= 2;
+        peer->window_ok /= 2;
+    }
+    adapt(peer);
+}
+
+const char* link_rate_name(link_rate_t rate) {
+    return rate < LINK_RATE_COUNT ? rates[rate].name : "?";
+}
+
+uint32_t link_rate_airtime_us(link_rate_t rate, size_t len) {
+    if (rate >= LINK_RATE_COUNT) {
+        return 0;
+    }
+
+    uint32_t bits = (uint32_t)(len + ESPNOW_FRAME_OVERHEAD) * 8;
+    const rate_info_t *info = &rates[rate];
+    if (!info->ofdm) {
+        // Long preamble at 1 Mbps, short preamble above
+        uint32_t preamble = rate == LINK_RATE_1M ? 192 : 96;
+        return preamble + (bits * 10 + info->mbps_x10 - 1) / info->mbps_x10;
+    }
+
+    // 20 us preamble + 4 us symbols (service and tail bits included) + 6 us signal extension
+    uint32_t bits_per_symbol = info->mbps_x10 * 4 / 10;
+    uint32_t symbols = (16 + bits + 6 + bits_per_symbol - 1) / bits_per_symbol;
+    return 20 + symbols * 4 + 6;
+}
@@ -0,0 +1,35 @@
+#ifndef FLEET_H
+#define FLEET_H
+
+#include "esp_err.h"
+#include "custom_mqtt_client.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define FLEET_SUMMARY_INTERVAL_MS 5000
+#define FLEET_REPORT_TTL_MS       (3 * FLEET_SUMMARY_INTERVAL_MS)
+#define FLEET_HYSTERESIS_DB       4
+#define FLEET_SUMMARY_CHUNK       24   // Devices per summary message
+
+// Cooperative multi-bridge mode. Bridges publish per-device RSSI summaries to
+// {prefix}/bridge/fleet/summary and each device is owned by the bridge with
+// the best link. Until fleet_init is called every device counts as local.
+//
+// 'command_cb' runs commands forwarded here by the bridge that received them.
+esp_err_t fleet_init(const char* bridge_id, mqtt_command_cb_t command_cb);
+
+// Record the RSSI of a frame received from 'mac'
+void fleet_observe(const uint8_t mac[6], int8_t rssi);
+
+// True when this bridge should forward frames from and send commands to 'mac'
+bool fleet_is_local(const uint8_t mac[6]);
+
+// Hand a command to the owning bridge. Returns false if the command should be
+// executed locally (this bridge owns the device, or nobody does).
+bool fleet_forward_command(const uint8_t mac[6], const char* mac_str, const char* command,
+                           const char* payload, const mqtt_response_ctx_t* response);
+
+// Bridge handler for {prefix}/bridge/fleet/{summary|forward|get}
+void fleet_handle_request(const char* action, const char* payload, int payload_len);
+
+#endif // FLEET_H
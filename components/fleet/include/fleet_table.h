@@ -0,0 +1,75 @@
+#ifndef FLEET_TABLE_H
+#define FLEET_TABLE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "device_registry.h"
+
+#define FLEET_MAX_BRIDGES   8
+#define FLEET_MAX_DEVICES   DEVICE_MAX
+#define FLEET_BRIDGE_ID_LEN 24
+
+// What one bridge last reported about its link to a device
+typedef struct {
+    bool valid;
+    int8_t rssi;              // Smoothed RSSI in dBm
+    uint32_t updated_ms;
+} fleet_report_t;
+
+// Indexed by the device's registry index
+typedef struct {
+    uint32_t generation;      // Of the device reference, 0 = unused
+    uint8_t mac[6];
+    int8_t owner;             // Bridge index, -1 when no bridge hears the device
+    bool local_valid;
+    int16_t local_avg_x16;    // EWMA of locally received RSSI, 1/16 dB units
+    uint32_t local_heard_ms;
+    fleet_report_t reports[FLEET_MAX_BRIDGES];  // As published, own summary included
+} fleet_device_t;
+
+// Ownership view of one bridge. Bridge index 0 is always the local bridge.
+// Elections only use published summaries, the bridge's own included once the
+// broker echoes it back, so every bridge sees the same inputs in the same
+// order and reaches the same verdict. Devices are passed in as references
+// into a registry the caller keeps (the bridge's shared one on the device).
+// Plain data without locking, so several instances can be simulated on a host.
+typedef struct {
+    char bridges[FLEET_MAX_BRIDGES][FLEET_BRIDGE_ID_LEN];
+    uint32_t bridge_seen_ms[FLEET_MAX_BRIDGES];
+    int bridge_count;
+    uint32_t report_ttl_ms;   // Reports older than this no longer count
+    int hysteresis_db;        // Margin a challenger needs over the current owner
+    fleet_device_t devices[FLEET_MAX_DEVICES];
+} fleet_table_t;
+
+typedef struct {
+    uint8_t mac[6];
+    int8_t rssi;
+} fleet_summary_entry_t;
+
+void fleet_table_init(fleet_table_t *table, const char *self_id,
+                      uint32_t report_ttl_ms, int hysteresis_db);
+
+// Fold a locally received frame's RSSI into the local average
+void fleet_table_observe(fleet_table_t *table, device_ref_t device, const uint8_t mac[6],
+                         int8_t rssi, uint32_t now_ms);
+
+// Record a summary entry from any bridge, this one included, and re-run the
+// device's election. Returns false if the bridge table is full.
+bool fleet_table_apply_report(fleet_table_t *table, const char *bridge_id, device_ref_t device,
+                              const uint8_t mac[6], int8_t rssi, uint32_t now_ms);
+
+// Current local averages of recently heard devices, for publishing. Returns the count.
+int fleet_table_local_summary(const fleet_table_t *table, uint32_t now_ms,
+                              fleet_summary_entry_t *out, int max_entries);
+
+// Owner of 'mac': best fresh RSSI wins, ties go to the lowest bridge id, and
+// a sitting owner is only replaced when beaten by 'hysteresis_db' or when its
+// report goes stale. Returns the owner's id, or NULL when no bridge has a
+// fresh report.
+const char* fleet_table_owner(fleet_table_t *table, device_ref_t device, uint32_t now_ms);
+
+// True when the local bridge owns the device or nobody does (local fallback)
+bool fleet_table_is_local(fleet_table_t *table, device_ref_t device, uint32_t now_ms);
+
+#endif // FLEET_TABLE_H
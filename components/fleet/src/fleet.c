@@ -0,0 +1,287 @@
+#include "fleet.h"
+#include "fleet_table.h"
+#include "devices.h"
+#include "shared_commands.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "cJSON.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <string.h>
+
+#define TAG "FLEET"
+
+#define FLEET_TASK_STACK    4096
+#define FLEET_TASK_PRIORITY 3
+
+static fleet_table_t table;
+static SemaphoreHandle_t lock = NULL;
+static mqtt_command_cb_t command_callback = NULL;
+
+static uint32_t now_ms(void) {
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+static void publish_summary(void) {
+    static fleet_summary_entry_t entries[FLEET_MAX_DEVICES];
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    int count = fleet_table_local_summary(&table, now_ms(), entries, FLEET_MAX_DEVICES);
+    xSemaphoreGive(lock);
+
+    // Chunked so each message fits the MQTT buffer without fragmenting
+    for (int start = 0; start < count; start += FLEET_SUMMARY_CHUNK) {
+        cJSON *root = cJSON_CreateObject();
+        cJSON_AddStringToObject(root, "bridge", table.bridges[0]);
+        cJSON *devices = cJSON_AddObjectToObject(root, "devices");
+        for (int i = start; i < count && i < start + FLEET_SUMMARY_CHUNK; i++) {
+            char mac_str[MAC_STR_LEN];
+            mac_bytes_to_str(entries[i].mac, mac_str);
+            cJSON_AddNumberToObject(devices, mac_str, entries[i].rssi);
+        }
+
+        char *json = cJSON_PrintUnformatted(root);
+        if (json) {
+            mqtt_publish_bridge_request("fleet", "summary", json);
+            cJSON_free(json);
+        }
+        cJSON_Delete(root);
+    }
+}
+
+static void fleet_task(void *arg) {
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(FLEET_SUMMARY_INTERVAL_MS));
+        publish_summary();
+    }
+}
+
+esp_err_t fleet_init(const char* bridge_id, mqtt_command_cb_t command_cb) {
+    if (lock != NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!bridge_id || bridge_id[0] == '\0' || strlen(bridge_id) >= FLEET_BRIDGE_ID_LEN) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    fleet_table_init(&table, bridge_id, FLEET_REPORT_TTL_MS, FLEET_HYSTERESIS_DB);
+    command_callback = command_cb;
+
+    lock = xSemaphoreCreateMutex();
+    if (!lock) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    if (xTaskCreate(fleet_task, "fleet", FLEET_TASK_STACK, NULL,
+                    FLEET_TASK_PRIORITY, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create fleet task");
+        return ESP_FAIL;
+    }
+
+    ESP_LOGI(TAG, "Fleet mode enabled as %s", bridge_id);
+    return ESP_OK;
+}
+
+void fleet_observe(const uint8_t mac[6], int8_t rssi) {
+    if (!lock || !mac) {
+        return;
+    }
+
+    device_ref_t device = devices_acquire(mac);
+    xSemaphoreTake(lock, portMAX_DELAY);
+    fleet_table_observe(&table, device, mac, rssi, now_ms());
+    xSemaphoreGive(lock);
+}
+
+bool fleet_is_local(const uint8_t mac[6]) {
+    if (!lock || !mac) {
+        return true;
+    }
+
+    device_ref_t device = devices_find(mac);
+    xSemaphoreTake(lock, portMAX_DELAY);
+    bool local = fleet_table_is_local(&table, device, now_ms());
+    xSemaphoreGive(lock);
+    return local;
+}
+
+bool fleet_forward_command(const uint8_t mac[6], const char* mac_str, const char* command,
+                           const char* payload, const mqtt_response_ctx_t* response) {
+    if (!lock || !mac) {
+        return false;
+    }
+
+    char owner[FLEET_BRIDGE_ID_LEN];
+    device_ref_t device = devices_find(mac);
+    xSemaphoreTake(lock, portMAX_DELAY);
+    const char *owner_id = fleet_table_owner(&table, device, now_ms());
+    bool remote = owner_id != NULL && owner_id != table.bridges[0];
+    if (remote) {
+        strcpy(owner, owner_id);
+    }
+    xSemaphoreGive(lock);
+
+    if (!remote) {
+        return false;
+    }
+
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "to", owner);
+    cJSON_AddStringToObject(root, "mac", mac_str);
+    cJSON_AddStringToObject(root, "command", command);
+    cJSON_AddStringToObject(root, "payload", payload ? payload : "");
+    if (response) {
+        char correlation[sizeof(response->correlation_data) * 2 + 1];
+        hex_encode(response->correlation_data, response->correlation_len, correlation);
+        cJSON_AddStringToObject(root, "response_topic", response->response_topic);
+        cJSON_AddStringToObject(root, "correlation", correlation);
+    }
+
+    char *json = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+    if (!json) {
+        // Better to try a weaker link than to drop the command
+        return false;
+    }
+
+    esp_err_t err = mqtt_publish_bridge_request("fleet", "forward", json);
+    cJSON_free(json);
+    if (err != ESP_OK) {
+        return false;
+    }
+
+    ESP_LOGI(TAG, "Forwarded %s for %s to %s", command, mac_str, owner);
+    return true;
+}
+
+static void apply_summary(const cJSON *root) {
+    const cJSON *bridge = cJSON_GetObjectItem(root, "bridge");
+    const cJSON *devices = cJSON_GetObjectItem(root, "devices");
+    if (!cJSON_IsString(bridge) || !cJSON_IsObject(devices)) {
+        ESP_LOGW(TAG, "Malformed fleet summary");
+        return;
+    }
+
+    uint32_t now = now_ms();
+    const cJSON *item;
+    xSemaphoreTake(lock, portMAX_DELAY);
+    cJSON_ArrayForEach(item, devices) {
+        uint8_t mac[6];
+        if (!cJSON_IsNumber(item) || !mac_str_to_bytes(item->string, mac) ||
+            item->valuedouble < -128 || item->valuedouble > 0) {
+            continue;
+        }
+        device_ref_t device = devices_acquire(mac);
+        if (!fleet_table_apply_report(&table, bridge->valuestring, device, mac,
+                                      (int8_t)item->valuedouble, now)) {
+            break;
+        }
+    }
+    xSemaphoreGive(lock);
+}
+
+static void run_forwarded(const cJSON *root) {
+    const cJSON *to = cJSON_GetObjectItem(root, "to");
+    if (!cJSON_IsString(to) || strcmp(to->valuestring, table.bridges[0]) != 0) {
+        return;
+    }
+
+    const cJSON *mac = cJSON_GetObjectItem(root, "mac");
+    const cJSON *command = cJSON_GetObjectItem(root, "command");
+    const cJSON *payload = cJSON_GetObjectItem(root, "payload");
+    if (!cJSON_IsString(mac) || !cJSON_IsString(command) || !cJSON_IsString(payload)) {
+        ESP_LOGW(TAG, "Malformed forwarded command");
+        return;
+    }
+
+    mqtt_response_ctx_t response = {0};
+    bool has_response = false;
+    const cJSON *response_topic = cJSON_GetObjectItem(root, "response_topic");
+    const cJSON *correlation = cJSON_GetObjectItem(root, "correlation");
+    if (cJSON_IsString(response_topic) &&
+        strlen(response_topic->valuestring) < sizeof(response.response_topic)) {
+        strcpy(response.response_topic, response_topic->valuestring);
+        int len = cJSON_IsString(correlation) ?
+                  hex_decode(correlation->valuestring, response.correlation_data,
+                               sizeof(response.correlation_data)) : 0;
+        response.correlation_len = len > 0 ? len : 0;
+        has_response = true;
+    }
+
+    // Executed unconditionally: ownership may have moved, but bouncing the
+    // command around again could loop
+    if (command_callback) {
+        command_callback(mac->valuestring, command->valuestring, payload->valuestring,
+                         has_response ? &response : NULL);
+    }
+}
+
+static void publish_owners(void) {
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "bridge", table.bridges[0]);
+    cJSON *devices = cJSON_AddArrayToObject(root, "devices");
+
+    uint32_t now = now_ms();
+    xSemaphoreTake(lock, portMAX_DELAY);
+    for (int i = 0; i < FLEET_MAX_DEVICES; i++) {
+        fleet_device_t *device = &table.devices[i];
+        device_ref_t ref = { .index = i, .generation = device->generation };
+        // Skip devices the shared registry has since forgotten
+        if (device->generation == 0 || !devices_current(ref)) {
+            continue;
+        }
+        const char *owner = fleet_table_owner(&table, ref, now);
+        if (!owner) {
+            continue;
+        }
+
+        char mac_str[MAC_STR_LEN];
+        mac_bytes_to_str(device->mac, mac_str);
+        cJSON *entry = cJSON_CreateObject();
+        cJSON_AddStringToObject(entry, "mac", mac_str);
+        cJSON_AddStringToObject(entry, "owner", owner);
+        cJSON_AddNumberToObject(entry, "rssi", device->reports[device->owner].rssi);
+        cJSON_AddItemToArray(devices, entry);
+    }
+    xSemaphoreGive(lock);
+
+    char *json = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+    if (json) {
+        mqtt_publish_bridge("fleet", json, false);
+        cJSON_free(json);
+    }
+}
+
+void fleet_handle_request(const char* action, const char* payload, int payload_len) {
+    if (!lock) {
+        return;
+    }
+
+    if (strcmp(action, "get") == 0) {
+        publish_owners();
+        return;
+    }
+
+    bool is_summary = strcmp(action, "summary") == 0;
+    if (!is_summary && strcmp(action, "forward") != 0) {
+        ESP_LOGW(TAG, "Unknown fleet request: %s", action);
+        return;
+    }
+
+    cJSON *root = cJSON_ParseWithLength(payload, payload_len);
+    if (!cJSON_IsObject(root)) {
+        ESP_LOGW(TAG, "Invalid fleet %s payload", action);
+        cJSON_Delete(root);
+        return;
+    }
+
+    if (is_summary) {
+        // Our own summaries come back too and count like any other
+        apply_summary(root);
+    } else {
+        run_forwarded(root);
+    }
+    cJSON_Delete(root);
+}
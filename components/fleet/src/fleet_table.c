@@ -0,0 +1,177 @@
+#include "fleet_table.h"
+#include <string.h>
+
+#define NO_OWNER (-1)
+
+static bool is_fresh(const fleet_table_t *table, const fleet_report_t *report, uint32_t now_ms) {
+    return report->valid && (uint32_t)(now_ms - report->updated_ms) <= table->report_ttl_ms;
+}
+
+// State of 'device', reset for 'mac' when created over an earlier holder of the index
+static fleet_device_t* find_device(fleet_table_t *table, device_ref_t device, const uint8_t mac[6],
+                                   bool create) {
+    if (device.index < 0 || device.index >= FLEET_MAX_DEVICES) {
+        return NULL;
+    }
+    fleet_device_t *entry = &table->devices[device.index];
+    if (entry->generation == device.generation) {
+        return entry;
+    }
+    if (!create) {
+        return NULL;
+    }
+
+    memset(entry, 0, sizeof(*entry));
+    entry->generation = device.generation;
+    memcpy(entry->mac, mac, sizeof(entry->mac));
+    entry->owner = NO_OWNER;
+    return entry;
+}
+
+static void forget_bridge(fleet_table_t *table, int index) {
+    for (int i = 0; i < FLEET_MAX_DEVICES; i++) {
+        table->devices[i].reports[index].valid = false;
+        if (table->devices[i].owner == index) {
+            table->devices[i].owner = NO_OWNER;
+        }
+    }
+}
+
+static int find_bridge(fleet_table_t *table, const char *bridge_id, uint32_t now_ms) {
+    for (int i = 0; i < table->bridge_count; i++) {
+        if (strcmp(table->bridges[i], bridge_id) == 0) {
+            return i;
+        }
+    }
+
+    int index = -1;
+    if (table->bridge_count < FLEET_MAX_BRIDGES) {
+        index = table->bridge_count++;
+    } else {
+        // Reuse the slot of a bridge that has gone quiet
+        for (int i = 1; i < FLEET_MAX_BRIDGES; i++) {
+            if ((uint32_t)(now_ms - table->bridge_seen_ms[i]) > table->report_ttl_ms) {
+                index = i;
+                break;
+            }
+        }
+        if (index < 0) {
+            return -1;
+        }
+        forget_bridge(table, index);
+    }
+
+    strncpy(table->bridges[index], bridge_id, FLEET_BRIDGE_ID_LEN - 1);
+    table->bridges[index][FLEET_BRIDGE_ID_LEN - 1] = '\0';
+    return index;
+}
+
+void fleet_table_init(fleet_table_t *table, const char *self_id,
+                      uint32_t report_ttl_ms, int hysteresis_db) {
+    memset(table, 0, sizeof(*table));
+    strncpy(table->bridges[0], self_id, FLEET_BRIDGE_ID_LEN - 1);
+    table->bridge_count = 1;
+    table->report_ttl_ms = report_ttl_ms;
+    table->hysteresis_db = hysteresis_db;
+}
+
+void fleet_table_observe(fleet_table_t *table, device_ref_t ref, const uint8_t mac[6],
+                         int8_t rssi, uint32_t now_ms) {
+    fleet_device_t *device = find_device(table, ref, mac, true);
+    if (!device) {
+        return;
+    }
+
+    if (device->local_valid && (uint32_t)(now_ms - device->local_heard_ms) <= table->report_ttl_ms) {
+        device->local_avg_x16 += (rssi * 16 - device->local_avg_x16) / 4;
+    } else {
+        device->local_avg_x16 = rssi * 16;
+    }
+    device->local_valid = true;
+    device->local_heard_ms = now_ms;
+    table->bridge_seen_ms[0] = now_ms;
+}
+
+static void elect(fleet_table_t *table, fleet_device_t *device, uint32_t now_ms) {
+    int best = NO_OWNER;
+    for (int i = 0; i < table->bridge_count; i++) {
+        const fleet_report_t *report = &device->reports[i];
+        if (!is_fresh(table, report, now_ms)) {
+            continue;
+        }
+        // Ties are broken by id so every bridge reaches the same verdict
+        if (best == NO_OWNER || report->rssi > device->reports[best].rssi ||
+            (report->rssi == device->reports[best].rssi &&
+             strcmp(table->bridges[i], table->bridges[best]) < 0)) {
+            best = i;
+        }
+    }
+
+    int current = device->owner;
+    if (best != NO_OWNER && current != NO_OWNER && current != best &&
+        is_fresh(table, &device->reports[current], now_ms) &&
+        device->reports[best].rssi < device->reports[current].rssi + table->hysteresis_db) {
+        best = current;
+    }
+    device->owner = best;
+}
+
+bool fleet_table_apply_report(fleet_table_t *table, const char *bridge_id, device_ref_t ref,
+                              const uint8_t mac[6], int8_t rssi, uint32_t now_ms) {
+    if (!bridge_id || bridge_id[0] == '\0') {
+        return false;
+    }
+
+    int index = find_bridge(table, bridge_id, now_ms);
+    if (index < 0) {
+        return false;
+    }
+    table->bridge_seen_ms[index] = now_ms;
+
+    fleet_device_t *device = find_device(table, ref, mac, true);
+    if (!device) {
+        return true;
+    }
+    device->reports[index] = (fleet_report_t) {
+        .valid = true,
+        .rssi = rssi,
+        .updated_ms = now_ms
+    };
+    elect(table, device, now_ms);
+    return true;
+}
+
+int fleet_table_local_summary(const fleet_table_t *table, uint32_t now_ms,
+                              fleet_summary_entry_t *out, int max_entries) {
+    int count = 0;
+    for (int i = 0; i < FLEET_MAX_DEVICES && count < max_entries; i++) {
+        const fleet_device_t *device = &table->devices[i];
+        if (device->generation == 0 || !device->local_valid ||
+            (uint32_t)(now_ms - device->local_heard_ms) > table->report_ttl_ms) {
+            continue;
+        }
+        memcpy(out[count].mac, device->mac, sizeof(out[count].mac));
+        int avg = device->local_avg_x16;
+        out[count].rssi = (int8_t)((avg + (avg < 0 ? -8 : 8)) / 16);
+        count++;
+    }
+    return count;
+}
+
+const char* fleet_table_owner(fleet_table_t *table, device_ref_t ref, uint32_t now_ms) {
+    fleet_device_t *device = find_device(table, ref, NULL, false);
+    if (!device) {
+        return NULL;
+    }
+
+    // Between summaries the verdict only changes when the owner goes quiet
+    if (device->owner == NO_OWNER || !is_fresh(table, &device->reports[device->owner], now_ms)) {
+        elect(table, device, now_ms);
+    }
+    return device->owner == NO_OWNER ? NULL : table->bridges[device->owner];
+}
+
+bool fleet_table_is_local(fleet_table_t *table, device_ref_t device, uint32_t now_ms) {
+    const char *owner = fleet_table_owner(table, device, now_ms);
+    return owner == NULL || owner == table->bridges[0];
+}
@@ -0,0 +1,42 @@
+#ifndef MEM_PROFILER_H
+#define MEM_PROFILER_H
+
+#include "esp_err.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Call sites whose heap use is attributed
+typedef enum {
+    MEM_SITE_CJSON = 0,       // Every cJSON allocation (via cJSON hooks)
+    MEM_SITE_COMMAND_PACKET,  // ESP-NOW command packets built from MQTT
+    MEM_SITE_MQTT_OUTBOX,     // Gauge: ESP-MQTT outbox size, set by the owner
+    MEM_SITE_COUNT
+} mem_site_t;
+
+typedef struct {
+    uint32_t current_bytes;
+    uint32_t peak_bytes;
+    uint32_t allocs;          // Lifetime allocation count
+} mem_site_stats_t;
+
+typedef void (*mem_profiler_report_cb_t)(void);
+
+// Route cJSON through the site allocator. Must run before any cJSON object
+// exists, since blocks carry a size header that plain free() does not expect:
+// strings from cJSON_Print* must be released with cJSON_free.
+void mem_profiler_install_cjson_hooks(void);
+
+// Start periodic reporting: 'report_cb' runs every 'interval_ms' from the
+// profiler task (0 = on demand only)
+esp_err_t mem_profiler_init(uint32_t interval_ms, mem_profiler_report_cb_t report_cb);
+
+void* mem_profiler_malloc(mem_site_t site, size_t size);
+void mem_profiler_free(mem_site_t site, void* ptr);
+void mem_profiler_set_gauge(mem_site_t site, uint32_t bytes);
+void mem_profiler_get_site(mem_site_t site, mem_site_stats_t* stats);
+
+// Sample heap, per-task stack high-water marks and site counters as JSON.
+// Caller must release the result with cJSON_free.
+char* mem_profiler_report_json(void);
+
+#endif // MEM_PROFILER_H
@@ -0,0 +1,236 @@
+#include "mem_profiler.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "cJSON.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdlib.h>
+#include <inttypes.h>
+
+#define TAG "MEM_PROFILER"
+
+#define MEM_PROFILER_TASK_STACK    3072
+#define MEM_PROFILER_TASK_PRIORITY 2
+
+// Prepended to every site allocation so frees can be attributed
+typedef struct {
+    uint32_t size;
+    uint32_t site;
+} block_header_t;
+
+static const char *site_names[MEM_SITE_COUNT] = {
+    [MEM_SITE_CJSON] = "cjson",
+    [MEM_SITE_COMMAND_PACKET] = "command_packet",
+    [MEM_SITE_MQTT_OUTBOX] = "mqtt_outbox",
+};
+
+#if !CONFIG_FREERTOS_USE_TRACE_FACILITY
+// Without the trace facility tasks can only be looked up by name
+static const char *known_tasks[] = {
+    "main", "wifi", "mqtt_task", "sys_evt", "tiT", "esp_timer",
+    "scheduler", "rpc_tracker", "mem_profiler"
+};
+#endif
+
+static mem_site_stats_t sites[MEM_SITE_COUNT];
+static portMUX_TYPE site_lock = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t report_interval_ms = 0;
+static mem_profiler_report_cb_t report_callback = NULL;
+static TaskHandle_t profiler_task = NULL;
+
+static void site_add(mem_site_t site, uint32_t size) {
+    taskENTER_CRITICAL(&site_lock);
+    sites[site].allocs++;
+    sites[site].current_bytes += size;
+    if (sites[site].current_bytes > sites[site].peak_bytes) {
+        sites[site].peak_bytes = sites[site].current_bytes;
+    }
+    taskEXIT_CRITICAL(&site_lock);
+}
+
+static void site_remove(mem_site_t site, uint32_t size) {
+    taskENTER_CRITICAL(&site_lock);
+    sites[site].current_bytes -= size;
+    taskEXIT_CRITICAL(&site_lock);
+}
+
+void* mem_profiler_malloc(mem_site_t site, size_t size) {
+    if (site >= MEM_SITE_COUNT) {
+        return NULL;
+    }
+
+    block_header_t *header = malloc(sizeof(block_header_t) + size);
+    if (!header) {
+        return NULL;
+    }
+    header->size = size;
+    header->site = site;
+    site_add(site, size);
+    return header + 1;
+}
+
+void mem_profiler_free(mem_site_t site, void* ptr) {
+    if (!ptr) {
+        return;
+    }
+
+    block_header_t *header = (block_header_t *)ptr - 1;
+    if (header->site != site) {
+        ESP_LOGE(TAG, "Block from %s freed as %s", site_names[header->site % MEM_SITE_COUNT],
+                 site_names[site % MEM_SITE_COUNT]);
+    }
+    site_remove(header->site % MEM_SITE_COUNT, header->size);
+    free(header);
+}
+
+void mem_profiler_set_gauge(mem_site_t site, uint32_t bytes) {
+    if (site >= MEM_SITE_COUNT) {
+        return;
+    }
+
+    taskENTER_CRITICAL(&site_lock);
+    sites[site].current_bytes = bytes;
+    if (bytes > sites[site].peak_bytes) {
+        sites[site].peak_bytes = bytes;
+    }
+    taskEXIT_CRITICAL(&site_lock);
+}
+
+void mem_profiler_get_site(mem_site_t site, mem_site_stats_t* stats) {
+    if (site >= MEM_SITE_COUNT || !stats) {
+        return;
+    }
+
+    taskENTER_CRITICAL(&site_lock);
+    *stats = sites[site];
+    taskEXIT_CRITICAL(&site_lock);
+}
+
+static void* cjson_malloc(size_t size) {
+    return mem_profiler_malloc(MEM_SITE_CJSON, size);
+}
+
+static void cjson_free(void *ptr) {
+    mem_profiler_free(MEM_SITE_CJSON, ptr);
+}
+
+void mem_profiler_install_cjson_hooks(void) {
+    cJSON_Hooks hooks = {
+        .malloc_fn = cjson_malloc,
+        .free_fn = cjson_free
+    };
+    cJSON_InitHooks(&hooks);
+}
+
+static void add_task_entry(cJSON *tasks, const char *name, UBaseType_t stack_free, UBaseType_t priority) {
+    cJSON *task = cJSON_CreateObject();
+    cJSON_AddStringToObject(task, "name", name);
+    cJSON_AddNumberToObject(task, "stack_free_min", stack_free);
+    cJSON_AddNumberToObject(task, "priority", priority);
+    cJSON_AddItemToArray(tasks, task);
+}
+
+static void add_tasks(cJSON *root) {
+    cJSON *tasks = cJSON_AddArrayToObject(root, "tasks");
+
+#if CONFIG_FREERTOS_USE_TRACE_FACILITY
+    // A little slack in case tasks are created while sampling
+    UBaseType_t capacity = uxTaskGetNumberOfTasks() + 4;
+    TaskStatus_t *status = malloc(capacity * sizeof(TaskStatus_t));
+    if (!status) {
+        ESP_LOGE(TAG, "No memory for task snapshot");
+        return;
+    }
+
+    UBaseType_t count = uxTaskGetSystemState(status, capacity, NULL);
+    for (UBaseType_t i = 0; i < count; i++) {
+        add_task_entry(tasks, status[i].pcTaskName, status[i].usStackHighWaterMark,
+                       status[i].uxCurrentPriority);
+    }
+    free(status);
+#else
+    for (size_t i = 0; i < sizeof(known_tasks) / sizeof(known_tasks[0]); i++) {
+        TaskHandle_t handle = xTaskGetHandle(known_tasks[i]);
+        if (handle) {
+            add_task_entry(tasks, known_tasks[i], uxTaskGetStackHighWaterMark(handle),
+                           uxTaskPriorityGet(handle));
+        }
+    }
+#endif
+}
+
+static void add_heap(cJSON *root) {
+    size_t free_size = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    size_t largest = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+
+    cJSON *heap = cJSON_AddObjectToObject(root, "heap");
+    cJSON_AddNumberToObject(heap, "free", free_size);
+    cJSON_AddNumberToObject(heap, "min_free", heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT));
+    cJSON_AddNumberToObject(heap, "largest_block", largest);
+    // Share of free memory not usable for a single allocation
+    cJSON_AddNumberToObject(heap, "fragmentation_pct",
+                            free_size ? 100.0 - (100.0 * largest / free_size) : 0.0);
+}
+
+static void add_sites(cJSON *root) {
+    cJSON *site_obj = cJSON_AddObjectToObject(root, "sites");
+    for (int i = 0; i < MEM_SITE_COUNT; i++) {
+        mem_site_stats_t stats;
+        mem_profiler_get_site(i, &stats);
+
+        cJSON *site = cJSON_AddObjectToObject(site_obj, site_names[i]);
+        cJSON_AddNumberToObject(site, "current", stats.current_bytes);
+        cJSON_AddNumberToObject(site, "peak", stats.peak_bytes);
+        if (i != MEM_SITE_MQTT_OUTBOX) {
+            cJSON_AddNumberToObject(site, "allocs", stats.allocs);
+        }
+    }
+}
+
+char* mem_profiler_report_json(void) {
+    cJSON *root = cJSON_CreateObject();
+    if (!root) {
+        return NULL;
+    }
+    // Sample the heap before the report itself grows
+    add_heap(root);
+    cJSON_AddNumberToObject(root, "uptime_s", esp_timer_get_time() / 1000000);
+    add_tasks(root);
+    add_sites(root);
+
+    char *json = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+    return json;
+}
+
+static void mem_profiler_task(void *arg) {
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(report_interval_ms));
+        if (report_callback) {
+            report_callback();
+        }
+    }
+}
+
+esp_err_t mem_profiler_init(uint32_t interval_ms, mem_profiler_report_cb_t report_cb) {
+    if (profiler_task != NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    report_interval_ms = interval_ms;
+    report_callback = report_cb;
+    if (interval_ms == 0) {
+        ESP_LOGI(TAG, "Memory profiler ready (on demand only)");
+        return ESP_OK;
+    }
+
+    if (xTaskCreate(mem_profiler_task, "mem_profiler", MEM_PROFILER_TASK_STACK, NULL,
+                    MEM_PROFILER_TASK_PRIORITY, &profiler_task) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create memory profiler task");
+        return ESP_FAIL;
+    }
+
+    ESP_LOGI(TAG, "Memory profiler reporting every %" PRIu32 " ms", interval_ms);
+    return ESP_OK;
+}
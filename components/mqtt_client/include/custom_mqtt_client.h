@@ -10,14 +10,52 @@ typedef struct {
     const char* uri;
     const char* username;
     const char* password;
+    bool protocol_v5;       // MQTT 5 with topic aliases (needs CONFIG_MQTT_PROTOCOL_5)
+    const char* shared_group; // Take commands through $share/{group}/..., NULL = every bridge gets all
+    const char* bridge_id;    // Publish bridge replies to {prefix}/bridge/{id}/{name}, NULL = {prefix}/bridge/{name}
 } mqtt_client_config_t;
 
-typedef void (*mqtt_command_cb_t)(const char* mac_str, const char* command, const char* payload);
+// MQTT 5 request/response properties of an incoming command
+typedef struct {
+    char response_topic[128];
+    uint8_t correlation_data[32];
+    uint16_t correlation_len;
+} mqtt_response_ctx_t;
+
+// Wire accounting for status publishes
+typedef struct {
+    uint32_t status_messages;
+    uint32_t bytes_v311;     // Encoded size had they been sent as MQTT 3.1.1 at the same QoS
+    uint32_t bytes_sent;     // Encoded size actually sent
+    uint32_t alias_hits;     // Publishes that carried only a topic alias
+} mqtt_wire_stats_t;
+
+// 'response' is NULL unless the command carried an MQTT 5 response topic
+typedef void (*mqtt_command_cb_t)(const char* mac_str, const char* command, const char* payload,
+                                  const mqtt_response_ctx_t* response);
+
+// Handler for bridge-level requests on {prefix}/bridge/{name}/{action}
+typedef void (*mqtt_bridge_cb_t)(const char* action, const char* payload, int payload_len);
+
+#define MQTT_MAX_BRIDGE_HANDLERS 8
 
 esp_err_t mqtt_init(mqtt_command_cb_t command_cb, 
               const mqtt_client_config_t* config,
               const char* topic_prefix);
 esp_err_t mqtt_publish_status(const char* mac_str, const char* command, const char* payload);
+esp_err_t mqtt_publish_result(const char* mac_str, const char* payload);
 void mqtt_publish_mac_address(const uint8_t mac[6]);
 
+esp_err_t mqtt_register_bridge_handler(const char* name, mqtt_bridge_cb_t cb);
+// Publish to {prefix}/bridge/{name}, or {prefix}/bridge/{bridge_id}/{name} when configured
+esp_err_t mqtt_publish_bridge(const char* name, const char* payload, bool retain);
+// Publish to {prefix}/bridge/{name}/{action}, i.e. to other bridges' handlers
+esp_err_t mqtt_publish_bridge_request(const char* name, const char* action, const char* payload);
+
+esp_err_t mqtt_publish_response(const mqtt_response_ctx_t* response, const char* payload);
+void mqtt_get_wire_stats(mqtt_wire_stats_t* stats);
+
+// Bytes queued in the ESP-MQTT outbox awaiting acknowledgement
+int mqtt_get_outbox_size(void);
+
 #endif // MQTT_CLIENT_H
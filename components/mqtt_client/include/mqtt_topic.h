@@ -0,0 +1,14 @@
+#ifndef MQTT_TOPIC_H
+#define MQTT_TOPIC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Split "<prefix>/<mac>/commands/<command>" (not NUL-terminated, as delivered
+// by ESP-MQTT) into its MAC and command parts. Fails without writing past
+// either output buffer when a part does not fit.
+bool mqtt_parse_command_topic(const char* topic, int topic_len, const char* prefix,
+                              char* mac_str, size_t mac_size,
+                              char* command, size_t command_size);
+
+#endif // MQTT_TOPIC_H
@@ -1,7 +1,13 @@
 #include "custom_mqtt_client.h"
+#include "mqtt_topic.h"
 #include "esp_log.h"
 #include "esp_mac.h"
 #include "esp_event.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#if CONFIG_MQTT_PROTOCOL_5
+#include "mqtt5_client.h"
+#endif
 #include <string.h>
 #include <inttypes.h>
 
@@ -9,8 +15,37 @@
 
 static esp_mqtt_client_handle_t client;
 static char topic_prefix[64];
+static char shared_group[32];
+static char bridge_id[MAC_STR_LEN];
 static mqtt_command_cb_t command_callback;
 
+typedef struct {
+    char name[24];
+    mqtt_bridge_cb_t callback;
+} bridge_handler_t;
+
+static bridge_handler_t bridge_handlers[MQTT_MAX_BRIDGE_HANDLERS];
+static int bridge_handler_count = 0;
+static bool connected = false;
+
+static bool use_v5 = false;
+static SemaphoreHandle_t publish_lock = NULL; // Publish properties apply to the next publish only
+static mqtt_wire_stats_t wire_stats;
+
+#if CONFIG_MQTT_PROTOCOL_5
+#define MQTT_V5_TOPIC_ALIAS_MAX 32
+
+// Client-to-broker aliases for status topics; alias number = index + 1
+typedef struct {
+    char topic[96];
+    bool established;       // Broker has seen topic + alias on this connection
+} topic_alias_t;
+
+static topic_alias_t topic_aliases[MQTT_V5_TOPIC_ALIAS_MAX];
+static int alias_limit = MQTT_V5_TOPIC_ALIAS_MAX;
+static int alias_next = 0;
+#endif
+
 static void log_error_if_nonzero(const char *message, int error_code)
 {
     if (error_code != 0) {
@@ -18,6 +53,190 @@ static void log_error_if_nonzero(const char *message, int error_code)
     }
 }
 
+static void subscribe_bridge_handler(esp_mqtt_client_handle_t mqtt_client, const bridge_handler_t *handler)
+{
+    char topic[128];
+    snprintf(topic, sizeof(topic), "%s/bridge/%s/+", topic_prefix, handler->name);
+    int msg_id = esp_mqtt_client_subscribe(mqtt_client, topic, 1);
+    ESP_LOGI(TAG, "Subscribed to %s, msg_id=%d", topic, msg_id);
+}
+
+static size_t varint_size(size_t value)
+{
+    size_t size = 1;
+    while (value >= 128) {
+        value >>= 7;
+        size++;
+    }
+    return size;
+}
+
+// Encoded size of a PUBLISH packet
+static size_t publish_wire_size(size_t topic_len, size_t payload_len, int qos, size_t property_len, bool v5)
+{
+    size_t remaining = 2 + topic_len + (qos > 0 ? 2 : 0) + payload_len;
+    if (v5) {
+        remaining += varint_size(property_len) + property_len;
+    }
+    return 1 + varint_size(remaining) + remaining;
+}
+
+static void record_status_publish(size_t topic_len, size_t sent_topic_len, size_t payload_len,
+                                  int qos, size_t property_len)
+{
+    wire_stats.status_messages++;
+    wire_stats.bytes_v311 += publish_wire_size(topic_len, payload_len, qos, 0, false);
+    wire_stats.bytes_sent += publish_wire_size(sent_topic_len, payload_len, qos, property_len, use_v5);
+}
+
+#if CONFIG_MQTT_PROTOCOL_5
+static void reset_topic_aliases(void)
+{
+    for (int i = 0; i < MQTT_V5_TOPIC_ALIAS_MAX; i++) {
+        topic_aliases[i].established = false;
+    }
+}
+
+// Returns the alias bound to 'topic', binding the next slot round-robin if needed; 0 = none
+static uint16_t topic_alias_for(const char *topic)
+{
+    if (alias_limit == 0 || strlen(topic) >= sizeof(topic_aliases[0].topic)) {
+        return 0;
+    }
+
+    for (int i = 0; i < alias_limit; i++) {
+        if (strcmp(topic_aliases[i].topic, topic) == 0) {
+            return i + 1;
+        }
+    }
+
+    // Rebinding an alias just means the next publish carries the full topic again
+    int slot = alias_next;
+    alias_next = (alias_next + 1) % alias_limit;
+    strcpy(topic_aliases[slot].topic, topic);
+    topic_aliases[slot].established = false;
+    return slot + 1;
+}
+
+static void set_topic_alias_property(uint16_t alias)
+{
+    esp_mqtt5_publish_property_config_t property = {0};
+    property.topic_alias = alias;
+    esp_mqtt5_client_set_publish_property(client, &property);
+}
+
+static int publish_status_v5(const char *topic, const char *payload, size_t payload_len)
+{
+    size_t topic_len = strlen(topic);
+    uint16_t alias = topic_alias_for(topic);
+    if (alias == 0) {
+        int msg_id = esp_mqtt_client_publish(client, topic, payload, payload_len, 1, 0);
+        if (msg_id >= 0) {
+            record_status_publish(topic_len, topic_len, payload_len, 1, 0);
+        }
+        return msg_id;
+    }
+
+    topic_alias_t *entry = &topic_aliases[alias - 1];
+    set_topic_alias_property(alias);
+
+    if (entry->established) {
+        // QoS 0: the outbox resends QoS 1 packets as encoded after a reconnect,
+        // and an alias-only packet is a protocol error on the new connection
+        int msg_id = esp_mqtt_client_publish(client, "", payload, payload_len, 0, 0);
+        if (msg_id >= 0) {
+            record_status_publish(topic_len, 0, payload_len, 0, 3);
+            wire_stats.alias_hits++;
+        }
+        return msg_id;
+    }
+
+    int msg_id = esp_mqtt_client_publish(client, topic, payload, payload_len, 1, 0);
+    if (msg_id < 0 && connected) {
+        // The client refuses aliases above the broker's Topic Alias Maximum;
+        // only blame the alias if the same publish goes through without it
+        set_topic_alias_property(0);
+        msg_id = esp_mqtt_client_publish(client, topic, payload, payload_len, 1, 0);
+        if (msg_id >= 0) {
+            ESP_LOGW(TAG, "Topic alias %u rejected, limiting aliases to %u", alias, alias - 1);
+            alias_limit = alias - 1;
+            alias_next = 0;
+            entry->topic[0] = '\0';
+            record_status_publish(topic_len, topic_len, payload_len, 1, 0);
+        }
+        return msg_id;
+    }
+
+    if (msg_id >= 0) {
+        entry->established = connected;
+        record_status_publish(topic_len, topic_len, payload_len, 1, 3);
+    }
+    return msg_id;
+}
+
+static bool extract_response_ctx(esp_mqtt_event_handle_t event, mqtt_response_ctx_t *response)
+{
+    if (!use_v5 || event->property == NULL || event->property->response_topic_len <= 0) {
+        return false;
+    }
+    if (event->property->response_topic_len >= (int)sizeof(response->response_topic) ||
+        event->property->correlation_data_len > sizeof(response->correlation_data)) {
+        ESP_LOGW(TAG, "Response topic or correlation data too long, not replying");
+        return false;
+    }
+
+    memcpy(response->response_topic, event->property->response_topic, event->property->response_topic_len);
+    response->response_topic[event->property->response_topic_len] = '\0';
+    response->correlation_len = event->property->correlation_data_len;
+    if (response->correlation_len > 0) {
+        memcpy(response->correlation_data, event->property->correlation_data, response->correlation_len);
+    }
+    return true;
+}
+#endif
+
+/**
+ * @brief Route {prefix}/bridge/{name}/{action} to the registered handler
+ *
+ * @return true if the topic belongs to the bridge namespace (handled or not)
+ */
+static bool dispatch_bridge_request(esp_mqtt_event_handle_t event)
+{
+    char bridge_prefix[96];
+    int prefix_len = snprintf(bridge_prefix, sizeof(bridge_prefix), "%s/bridge/", topic_prefix);
+    if (event->topic_len <= prefix_len || strncmp(event->topic, bridge_prefix, prefix_len) != 0) {
+        return false;
+    }
+
+    char name[64];
+    int name_len = event->topic_len - prefix_len;
+    if (name_len >= (int)sizeof(name)) {
+        ESP_LOGW(TAG, "Bridge topic too long, ignoring");
+        return true;
+    }
+    memcpy(name, event->topic + prefix_len, name_len);
+    name[name_len] = '\0';
+
+    char *action = strchr(name, '/');
+    if (!action) {
+        return true;
+    }
+    *action++ = '\0';
+
+    if (event->current_data_offset != 0 || event->data_len != event->total_data_len) {
+        ESP_LOGW(TAG, "Fragmented bridge request on %s/%s dropped", name, action);
+        return true;
+    }
+
+    for (int i = 0; i < bridge_handler_count; i++) {
+        if (strcmp(bridge_handlers[i].name, name) == 0) {
+            bridge_handlers[i].callback(action, event->data, event->data_len);
+            break;
+        }
+    }
+    return true;
+}
+
 /**
  * @brief Event handler registered to receive MQTT events
  *
@@ -39,15 +258,41 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_
         case MQTT_EVENT_CONNECTED:
             ESP_LOGI(TAG, "MQTT_EVENT_CONNECTED");
             
-            // Subscribe to commands topic
-            char subscribe_topic[128];
-            snprintf(subscribe_topic, sizeof(subscribe_topic), "%s/+/commands/#", topic_prefix);
+            // Subscribe to commands topic; in a shared group the broker hands each command to one bridge
+            char subscribe_topic[160];
+            if (shared_group[0] != '\0') {
+                snprintf(subscribe_topic, sizeof(subscribe_topic), "$share/%s/%s/+/commands/#",
+                         shared_group, topic_prefix);
+            } else {
+                snprintf(subscribe_topic, sizeof(subscribe_topic), "%s/+/commands/#", topic_prefix);
+            }
             msg_id = esp_mqtt_client_subscribe(event_client, subscribe_topic, 1);
             ESP_LOGI(TAG, "Sent subscribe successful, msg_id=%d", msg_id);
+
+            for (int i = 0; i < bridge_handler_count; i++) {
+                subscribe_bridge_handler(event_client, &bridge_handlers[i]);
+            }
+
+            xSemaphoreTake(publish_lock, portMAX_DELAY);
+#if CONFIG_MQTT_PROTOCOL_5
+            // Topic aliases only live as long as the network connection, and
+            // a new broker may allow more of them
+            reset_topic_aliases();
+            alias_limit = MQTT_V5_TOPIC_ALIAS_MAX;
+            alias_next = 0;
+#endif
+            connected = true;
+            xSemaphoreGive(publish_lock);
             break;
             
         case MQTT_EVENT_DISCONNECTED:
             ESP_LOGI(TAG, "MQTT_EVENT_DISCONNECTED");
+            xSemaphoreTake(publish_lock, portMAX_DELAY);
+#if CONFIG_MQTT_PROTOCOL_5
+            reset_topic_aliases();
+#endif
+            connected = false;
+            xSemaphoreGive(publish_lock);
             break;
             
         case MQTT_EVENT_SUBSCRIBED:
@@ -67,36 +312,37 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_
             printf("TOPIC=%.*s\r\n", event->topic_len, event->topic);
             printf("DATA=%.*s\r\n", event->data_len, event->data);
             
+            if (dispatch_bridge_request(event)) {
+                break;
+            }
+            
             if (command_callback) {
-                // Extract topic and data
-                char topic[256];
-                strncpy(topic, event->topic, event->topic_len);
-                topic[event->topic_len] = '\0';
+                // Extract MAC and command from topic
+                // Format: <prefix>/<mac>/commands/<command>
+                char mac_str[MAC_STR_LEN];
+                char command[32];
+                if (!mqtt_parse_command_topic(event->topic, event->topic_len, topic_prefix,
+                                              mac_str, sizeof(mac_str), command, sizeof(command))) {
+                    ESP_LOGW(TAG, "Ignoring malformed command topic");
+                    break;
+                }
                 
+                // Oversized or fragmented payloads are dropped rather than truncated
                 char data[256];
-                strncpy(data, event->data, event->data_len);
+                if (event->data_len >= (int)sizeof(data) || event->data_len != event->total_data_len) {
+                    ESP_LOGW(TAG, "Ignoring %d byte command payload", event->total_data_len);
+                    break;
+                }
+                memcpy(data, event->data, event->data_len);
                 data[event->data_len] = '\0';
                 
-                // Extract MAC from topic
-                // Format: <prefix>/<mac>/commands/<command>
-                char *mac_start = strstr(topic, topic_prefix);
-                if (mac_start) {
-                    mac_start += strlen(topic_prefix) + 1; // Skip prefix and '/'
-                    char *mac_end = strchr(mac_start, '/');
-                    if (mac_end) {
-                        char mac_str[18];
-                        size_t mac_len = mac_end - mac_start;
-                        strncpy(mac_str, mac_start, mac_len);
-                        mac_str[mac_len] = '\0';
-                        
-                        // Extract command
-                        char *cmd_start = strstr(topic, "commands/");
-                        if (cmd_start) {
-                            cmd_start += 9; // length of "commands/"
-                            command_callback(mac_str, cmd_start, data);
-                        }
-                    }
-                }
+                mqtt_response_ctx_t response;
+                bool has_response = false;
+#if CONFIG_MQTT_PROTOCOL_5
+                has_response = extract_response_ctx(event, &response);
+#endif
+                
+                command_callback(mac_str, command, data, has_response ? &response : NULL);
             }
             break;
             
@@ -122,6 +368,16 @@ esp_err_t mqtt_init(mqtt_command_cb_t command_cb,
     command_callback = command_cb;
     strncpy(topic_prefix, prefix, sizeof(topic_prefix)-1);
     topic_prefix[sizeof(topic_prefix)-1] = '\0';
+    shared_group[0] = '\0';
+    if (config->shared_group) {
+        strncpy(shared_group, config->shared_group, sizeof(shared_group)-1);
+        shared_group[sizeof(shared_group)-1] = '\0';
+    }
+    bridge_id[0] = '\0';
+    if (config->bridge_id) {
+        strncpy(bridge_id, config->bridge_id, sizeof(bridge_id)-1);
+        bridge_id[sizeof(bridge_id)-1] = '\0';
+    }
     
     // Configure MQTT client
     esp_mqtt_client_config_t mqtt_cfg = {0};
@@ -129,6 +385,24 @@ esp_err_t mqtt_init(mqtt_command_cb_t command_cb,
     mqtt_cfg.credentials.username = config->username;
     mqtt_cfg.credentials.authentication.password = config->password;
     
+    use_v5 = false;
+    if (config->protocol_v5) {
+#if CONFIG_MQTT_PROTOCOL_5
+        mqtt_cfg.session.protocol_ver = MQTT_PROTOCOL_V_5;
+        use_v5 = true;
+#else
+        ESP_LOGW(TAG, "MQTT 5 requested but CONFIG_MQTT_PROTOCOL_5 is disabled, using 3.1.1");
+#endif
+    }
+    if (!use_v5) {
+        mqtt_cfg.session.protocol_ver = MQTT_PROTOCOL_V_3_1_1;
+    }
+    
+    publish_lock = xSemaphoreCreateMutex();
+    if (publish_lock == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    
     // Initialize MQTT client
     client = esp_mqtt_client_init(&mqtt_cfg);
     if (client == NULL) {
@@ -152,8 +426,43 @@ esp_err_t mqtt_publish_status(const char* mac_str, const char* command, const ch
     
     char topic[256];
     snprintf(topic, sizeof(topic), "%s/%s/status/%s/data", topic_prefix, mac_str, command);
+    size_t payload_len = strlen(payload);
+    
+    xSemaphoreTake(publish_lock, portMAX_DELAY);
+    int msg_id;
+#if CONFIG_MQTT_PROTOCOL_5
+    if (use_v5) {
+        msg_id = publish_status_v5(topic, payload, payload_len);
+    } else
+#endif
+    {
+        msg_id = esp_mqtt_client_publish(client, topic, payload, payload_len, 1, 0);
+        if (msg_id >= 0) {
+            record_status_publish(strlen(topic), strlen(topic), payload_len, 1, 0);
+        }
+    }
+    xSemaphoreGive(publish_lock);
+    
+    if (msg_id < 0) {
+        ESP_LOGE(TAG, "Failed to publish to %s", topic);
+        return ESP_FAIL;
+    }
+    
+    ESP_LOGI(TAG, "Published to %s, msg_id=%d", topic, msg_id);
+    return ESP_OK;
+}
+
+esp_err_t mqtt_publish_result(const char* mac_str, const char* payload) {
+    if (client == NULL) {
+        return ESP_FAIL;
+    }
+    
+    char topic[128];
+    snprintf(topic, sizeof(topic), "%s/%s/result", topic_prefix, mac_str);
     
+    xSemaphoreTake(publish_lock, portMAX_DELAY);
     int msg_id = esp_mqtt_client_publish(client, topic, payload, 0, 1, 0);
+    xSemaphoreGive(publish_lock);
     if (msg_id < 0) {
         ESP_LOGE(TAG, "Failed to publish to %s", topic);
         return ESP_FAIL;
@@ -169,17 +478,130 @@ void mqtt_publish_mac_address(const uint8_t mac[6]) {
         return;
     }
     
-    char mac_str[18];
-    snprintf(mac_str, sizeof(mac_str), "%02x:%02x:%02x:%02x:%02x:%02x",
-             mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+    char mac_str[MAC_STR_LEN];
+    mac_bytes_to_str(mac, mac_str);
 
     char topic[128];
     snprintf(topic, sizeof(topic), "%s/bridge/mac", topic_prefix);
 
+    xSemaphoreTake(publish_lock, portMAX_DELAY);
     int msg_id = esp_mqtt_client_publish(client, topic, mac_str, 0, 1, 0);
+    xSemaphoreGive(publish_lock);
     if (msg_id < 0) {
         ESP_LOGE(TAG, "Failed to publish MAC address");
     } else {
         ESP_LOGI(TAG, "Published MAC address: %s, msg_id=%d", mac_str, msg_id);
     }
 }
+
+esp_err_t mqtt_register_bridge_handler(const char* name, mqtt_bridge_cb_t cb) {
+    if (name == NULL || cb == NULL || strlen(name) >= sizeof(bridge_handlers[0].name)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (bridge_handler_count >= MQTT_MAX_BRIDGE_HANDLERS) {
+        ESP_LOGE(TAG, "No free bridge handler slots for %s", name);
+        return ESP_ERR_NO_MEM;
+    }
+
+    bridge_handler_t *handler = &bridge_handlers[bridge_handler_count++];
+    strcpy(handler->name, name);
+    handler->callback = cb;
+
+    // Handlers registered before connecting are subscribed on MQTT_EVENT_CONNECTED
+    if (client != NULL && connected) {
+        subscribe_bridge_handler(client, handler);
+    }
+    return ESP_OK;
+}
+
+esp_err_t mqtt_publish_bridge(const char* name, const char* payload, bool retain) {
+    if (client == NULL) {
+        return ESP_FAIL;
+    }
+
+    // Bridges sharing a prefix all answer the same requests; keep their replies apart
+    char topic[128];
+    if (bridge_id[0] != '\0') {
+        snprintf(topic, sizeof(topic), "%s/bridge/%s/%s", topic_prefix, bridge_id, name);
+    } else {
+        snprintf(topic, sizeof(topic), "%s/bridge/%s", topic_prefix, name);
+    }
+
+    xSemaphoreTake(publish_lock, portMAX_DELAY);
+    int msg_id = esp_mqtt_client_publish(client, topic, payload, 0, 1, retain);
+    xSemaphoreGive(publish_lock);
+    if (msg_id < 0) {
+        ESP_LOGE(TAG, "Failed to publish to %s", topic);
+        return ESP_FAIL;
+    }
+
+    ESP_LOGI(TAG, "Published to %s, msg_id=%d", topic, msg_id);
+    return ESP_OK;
+}
+
+esp_err_t mqtt_publish_bridge_request(const char* name, const char* action, const char* payload) {
+    if (client == NULL) {
+        return ESP_FAIL;
+    }
+
+    char topic[128];
+    snprintf(topic, sizeof(topic), "%s/bridge/%s/%s", topic_prefix, name, action);
+
+    xSemaphoreTake(publish_lock, portMAX_DELAY);
+    int msg_id = esp_mqtt_client_publish(client, topic, payload, 0, 1, 0);
+    xSemaphoreGive(publish_lock);
+    if (msg_id < 0) {
+        ESP_LOGE(TAG, "Failed to publish to %s", topic);
+        return ESP_FAIL;
+    }
+
+    ESP_LOGD(TAG, "Published to %s, msg_id=%d", topic, msg_id);
+    return ESP_OK;
+}
+
+esp_err_t mqtt_publish_response(const mqtt_response_ctx_t* response, const char* payload) {
+    if (client == NULL || response == NULL || payload == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(publish_lock, portMAX_DELAY);
+#if CONFIG_MQTT_PROTOCOL_5
+    esp_mqtt5_publish_property_config_t property = {0};
+    if (response->correlation_len > 0) {
+        property.correlation_data = (const char *)response->correlation_data;
+        property.correlation_data_len = response->correlation_len;
+    }
+    esp_mqtt5_client_set_publish_property(client, &property);
+#endif
+    int msg_id = esp_mqtt_client_publish(client, response->response_topic, payload, 0, 1, 0);
+    xSemaphoreGive(publish_lock);
+
+    if (msg_id < 0) {
+        ESP_LOGE(TAG, "Failed to publish response to %s", response->response_topic);
+        return ESP_FAIL;
+    }
+
+    ESP_LOGI(TAG, "Published response to %s, msg_id=%d", response->response_topic, msg_id);
+    return ESP_OK;
+}
+
+void mqtt_get_wire_stats(mqtt_wire_stats_t* stats) {
+    if (stats == NULL) {
+        return;
+    }
+
+    if (publish_lock) {
+        xSemaphoreTake(publish_lock, portMAX_DELAY);
+    }
+    *stats = wire_stats;
+    if (publish_lock) {
+        xSemaphoreGive(publish_lock);
+    }
+}
+
+int mqtt_get_outbox_size(void) {
+    if (client == NULL) {
+        return 0;
+    }
+    return esp_mqtt_client_get_outbox_size(client);
+}
@@ -0,0 +1,43 @@
+#include "mqtt_topic.h"
+#include <string.h>
+
+#define COMMANDS_SEGMENT "commands/"
+
+static bool copy_segment(const char* start, size_t len, char* out, size_t out_size) {
+    if (len == 0 || len >= out_size) {
+        return false;
+    }
+    memcpy(out, start, len);
+    out[len] = '\0';
+    return true;
+}
+
+bool mqtt_parse_command_topic(const char* topic, int topic_len, const char* prefix,
+                              char* mac_str, size_t mac_size,
+                              char* command, size_t command_size) {
+    if (!topic || topic_len <= 0 || !prefix || !mac_str || !command) {
+        return false;
+    }
+
+    const char* end = topic + topic_len;
+    size_t prefix_len = strlen(prefix);
+    if ((size_t)topic_len <= prefix_len + 1 ||
+        memcmp(topic, prefix, prefix_len) != 0 || topic[prefix_len] != '/') {
+        return false;
+    }
+
+    const char* mac_start = topic + prefix_len + 1;
+    const char* mac_end = memchr(mac_start, '/', end - mac_start);
+    if (!mac_end || !copy_segment(mac_start, mac_end - mac_start, mac_str, mac_size)) {
+        return false;
+    }
+
+    const char* segment = mac_end + 1;
+    size_t segment_len = strlen(COMMANDS_SEGMENT);
+    if ((size_t)(end - segment) <= segment_len || memcmp(segment, COMMANDS_SEGMENT, segment_len) != 0) {
+        return false;
+    }
+
+    const char* cmd_start = segment + segment_len;
+    return copy_segment(cmd_start, end - cmd_start, command, command_size);
+}
@@ -0,0 +1,62 @@
+#ifndef RPC_TRACKER_H
+#define RPC_TRACKER_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define RPC_MAX_PENDING        32
+#define RPC_TICK_MS            100
+#define RPC_DEFAULT_TIMEOUT_MS 5000
+
+typedef enum {
+    RPC_OUTCOME_OK = 0,       // Device answered with a response frame
+    RPC_OUTCOME_TIMEOUT,      // No response before the deadline
+    RPC_OUTCOME_SEND_FAILED,  // ESP-NOW refused or could not deliver the frame
+    RPC_OUTCOME_BUSY          // Not sent: the same command is pending for the device
+} rpc_outcome_t;
+
+// Tracker-assigned reference to a pending request; stale handles match nothing
+typedef uint32_t rpc_handle_t;
+#define RPC_HANDLE_NONE 0
+
+typedef struct {
+    uint8_t mac[6];
+    uint32_t request_id;
+    uint8_t command;           // Original command type
+    rpc_outcome_t outcome;
+    int64_t latency_us;        // From MQTT receipt to completion
+    const uint8_t *response;   // Response frame data (RPC_OUTCOME_OK only)
+    uint8_t response_len;
+    void *user_ctx;            // As passed to rpc_tracker_begin; owned by the callback
+} rpc_result_t;
+
+// Invoked exactly once per tracked request, outside the tracker lock
+typedef void (*rpc_result_cb_t)(const rpc_result_t *result);
+
+esp_err_t rpc_tracker_init(rpc_result_cb_t result_cb);
+
+// Start tracking a command sent to 'mac'. 'received_us' is the esp_timer
+// timestamp at which the MQTT command arrived. Frames carry no request id,
+// so only one request per device and command may be pending: a second one
+// gets ESP_ERR_INVALID_STATE. Returns ESP_ERR_NO_MEM when the pending table
+// is full. On error user_ctx is left to the caller.
+esp_err_t rpc_tracker_begin(const uint8_t mac[6], uint32_t request_id, uint8_t command,
+                            int64_t received_us, uint32_t timeout_ms, void *user_ctx,
+                            rpc_handle_t *handle);
+
+// Finish a request whose frame ESP-NOW refused or failed to deliver. Safe to
+// call from the Wi-Fi task: the result is reported by the tracker task.
+void rpc_tracker_fail(rpc_handle_t handle);
+
+// Match a response frame (command with the CMD_RESPONSE bit set) to the
+// pending request for that device and command. A bare CMD_RESPONSE only
+// matches when a single request is pending for the device. Returns true if a
+// request was completed.
+bool rpc_tracker_match_response(const uint8_t mac[6], uint8_t response_cmd,
+                                const uint8_t *data, uint8_t data_len);
+
+// Monotonic id for commands that did not carry one
+uint32_t rpc_tracker_next_id(void);
+
+#endif // RPC_TRACKER_H
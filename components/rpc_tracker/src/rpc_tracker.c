@@ -0,0 +1,232 @@
+#include "rpc_tracker.h"
+#include "timer_wheel.h"
+#include "shared_commands.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/queue.h"
+#include <string.h>
+#include <inttypes.h>
+
+#define TAG "RPC"
+
+#define RPC_TASK_STACK    3072
+#define RPC_TASK_PRIORITY 5
+
+typedef struct {
+    bool used;
+    uint16_t generation;       // Bumped on every reuse so old handles go stale
+    uint8_t mac[6];
+    uint32_t request_id;
+    uint8_t command;
+    int64_t received_us;
+    void *user_ctx;
+    timer_wheel_timer_t timeout;
+} rpc_pending_t;
+
+static rpc_pending_t pending[RPC_MAX_PENDING];
+static timer_wheel_t wheel;   // Ticks of RPC_TICK_MS
+static SemaphoreHandle_t lock = NULL;
+static rpc_result_cb_t result_callback = NULL;
+static uint32_t last_request_id = 0;
+static TaskHandle_t task_handle = NULL;
+static QueueHandle_t failed_queue = NULL;   // Handles passed to rpc_tracker_fail
+
+// Timeouts and send failures collected during one tick; only touched by the
+// tracker task
+static rpc_result_t expired[RPC_MAX_PENDING];
+static int expired_count = 0;
+
+static uint32_t current_tick(void) {
+    return (uint32_t)(esp_timer_get_time() / (1000 * RPC_TICK_MS));
+}
+
+// Must be called with the lock held. The result callback is invoked by the
+// caller after releasing the lock: it publishes over MQTT, and the MQTT task
+// may be blocked on this lock while holding the client's own lock.
+static void complete(rpc_pending_t *entry, rpc_outcome_t outcome,
+                     const uint8_t *data, uint8_t data_len, rpc_result_t *result) {
+    *result = (rpc_result_t) {
+        .request_id = entry->request_id,
+        .command = entry->command,
+        .outcome = outcome,
+        .latency_us = esp_timer_get_time() - entry->received_us,
+        .response = data,
+        .response_len = data_len,
+        .user_ctx = entry->user_ctx
+    };
+    memcpy(result->mac, entry->mac, sizeof(result->mac));
+
+    timer_wheel_del(&entry->timeout);
+    entry->used = false;
+}
+
+static void on_timeout(timer_wheel_timer_t *timer, void *arg) {
+    rpc_pending_t *entry = (rpc_pending_t *)arg;
+    ESP_LOGW(TAG, "Request %" PRIu32 " (%s) timed out",
+             entry->request_id, command_to_str(entry->command));
+    complete(entry, RPC_OUTCOME_TIMEOUT, NULL, 0, &expired[expired_count++]);
+}
+
+// Must be called with the lock held
+static rpc_pending_t* find_handle(rpc_handle_t handle) {
+    uint32_t index = handle & 0xFF;
+    if (handle == RPC_HANDLE_NONE || index >= RPC_MAX_PENDING) {
+        return NULL;
+    }
+    rpc_pending_t *entry = &pending[index];
+    return entry->used && entry->generation == (handle >> 8) ? entry : NULL;
+}
+
+static void rpc_task(void *arg) {
+    while (1) {
+        // Woken early by rpc_tracker_fail
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(RPC_TICK_MS));
+
+        xSemaphoreTake(lock, portMAX_DELAY);
+        expired_count = 0;
+        rpc_handle_t handle;
+        while (xQueueReceive(failed_queue, &handle, 0) == pdTRUE) {
+            rpc_pending_t *entry = find_handle(handle);
+            if (entry) {
+                ESP_LOGW(TAG, "Request %" PRIu32 " (%s) not delivered",
+                         entry->request_id, command_to_str(entry->command));
+                complete(entry, RPC_OUTCOME_SEND_FAILED, NULL, 0, &expired[expired_count++]);
+            }
+        }
+        timer_wheel_advance(&wheel, current_tick());
+        xSemaphoreGive(lock);
+
+        for (int i = 0; i < expired_count && result_callback; i++) {
+            result_callback(&expired[i]);
+        }
+    }
+}
+
+esp_err_t rpc_tracker_init(rpc_result_cb_t result_cb) {
+    if (lock != NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    lock = xSemaphoreCreateMutex();
+    failed_queue = xQueueCreate(RPC_MAX_PENDING, sizeof(rpc_handle_t));
+    if (!lock || !failed_queue) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    result_callback = result_cb;
+    memset(pending, 0, sizeof(pending));
+    for (int i = 0; i < RPC_MAX_PENDING; i++) {
+        timer_wheel_timer_init(&pending[i].timeout, on_timeout, &pending[i]);
+    }
+    timer_wheel_init(&wheel, current_tick());
+
+    if (xTaskCreate(rpc_task, "rpc_tracker", RPC_TASK_STACK, NULL,
+                    RPC_TASK_PRIORITY, &task_handle) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create RPC tracker task");
+        return ESP_FAIL;
+    }
+
+    ESP_LOGI(TAG, "RPC tracker initialized (%d pending max)", RPC_MAX_PENDING);
+    return ESP_OK;
+}
+
+esp_err_t rpc_tracker_begin(const uint8_t mac[6], uint32_t request_id, uint8_t command,
+                            int64_t received_us, uint32_t timeout_ms, void *user_ctx,
+                            rpc_handle_t *handle) {
+    if (!lock || !mac || !handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *handle = RPC_HANDLE_NONE;
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    rpc_pending_t *entry = NULL;
+    for (int i = 0; i < RPC_MAX_PENDING; i++) {
+        if (!pending[i].used) {
+            entry = entry ? entry : &pending[i];
+        } else if (pending[i].command == command &&
+                   memcmp(pending[i].mac, mac, sizeof(pending[i].mac)) == 0) {
+            // A response could not tell the two apart
+            xSemaphoreGive(lock);
+            ESP_LOGW(TAG, "Request %" PRIu32 " rejected: %s already pending as %" PRIu32,
+                     request_id, command_to_str(command), pending[i].request_id);
+            return ESP_ERR_INVALID_STATE;
+        }
+    }
+    if (!entry) {
+        xSemaphoreGive(lock);
+        ESP_LOGW(TAG, "Pending table full, request %" PRIu32 " not tracked", request_id);
+        return ESP_ERR_NO_MEM;
+    }
+
+    entry->used = true;
+    entry->generation = entry->generation == UINT16_MAX ? 1 : entry->generation + 1;
+    memcpy(entry->mac, mac, sizeof(entry->mac));
+    entry->request_id = request_id;
+    entry->command = command;
+    entry->received_us = received_us;
+    entry->user_ctx = user_ctx;
+
+    uint32_t ticks = (timeout_ms + RPC_TICK_MS - 1) / RPC_TICK_MS;
+    timer_wheel_add(&wheel, &entry->timeout, current_tick() + (ticks ? ticks : 1));
+    *handle = ((rpc_handle_t)entry->generation << 8) | (rpc_handle_t)(entry - pending);
+    xSemaphoreGive(lock);
+    return ESP_OK;
+}
+
+void rpc_tracker_fail(rpc_handle_t handle) {
+    if (!failed_queue || handle == RPC_HANDLE_NONE) {
+        return;
+    }
+
+    // If the queue is full the request still ends, as a timeout
+    if (xQueueSend(failed_queue, &handle, 0) == pdTRUE) {
+        xTaskNotifyGive(task_handle);
+    }
+}
+
+bool rpc_tracker_match_response(const uint8_t mac[6], uint8_t response_cmd,
+                                const uint8_t *data, uint8_t data_len) {
+    if (!lock || !mac || !(response_cmd & CMD_RESPONSE)) {
+        return false;
+    }
+
+    uint8_t original = response_cmd & (uint8_t)~CMD_RESPONSE;
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    // At most one request per device and command is pending, so a specific
+    // response names its request; a bare one must be unambiguous
+    rpc_pending_t *match = NULL;
+    int candidates = 0;
+    for (int i = 0; i < RPC_MAX_PENDING; i++) {
+        rpc_pending_t *entry = &pending[i];
+        if (!entry->used || memcmp(entry->mac, mac, sizeof(entry->mac)) != 0) {
+            continue;
+        }
+        if (original != 0 && entry->command != original) {
+            continue;
+        }
+        match = entry;
+        candidates++;
+    }
+    rpc_result_t result;
+    bool found = candidates == 1;
+    if (found) {
+        complete(match, RPC_OUTCOME_OK, data, data_len, &result);
+    } else if (candidates > 1) {
+        ESP_LOGW(TAG, "Bare response matches %d pending requests, ignoring it", candidates);
+    }
+    xSemaphoreGive(lock);
+
+    if (found && result_callback) {
+        result_callback(&result);
+    }
+    return found;
+}
+
+uint32_t rpc_tracker_next_id(void) {
+    uint32_t id = __atomic_add_fetch(&last_request_id, 1, __ATOMIC_RELAXED);
+    return id ? id : __atomic_add_fetch(&last_request_id, 1, __ATOMIC_RELAXED);
+}
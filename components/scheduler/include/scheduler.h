@@ -0,0 +1,52 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include "esp_err.h"
+#include "shared_commands.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
+
+#ifndef SCHEDULER_MAX_ENTRIES
+#define SCHEDULER_MAX_ENTRIES 128
+#endif
+
+#define SCHEDULER_MAX_TARGETS 8     // Devices per entry (a "group")
+#define SCHEDULE_ANY          (-1)  // Wildcard for minute/hour
+#define SCHEDULE_ALL_DAYS     0x7F
+
+// Same signature as espnow_send so it can be passed in directly
+typedef esp_err_t (*schedule_send_fn_t)(const uint8_t *mac_addr, const command_packet_t *cmd);
+
+// Cron-like entry: fires at hh:mm on every day set in 'days' (bit 0 = Sunday)
+typedef struct {
+    uint16_t id;
+    bool enabled;
+    command_type_t action;          // CMD_START or CMD_STOP
+    int8_t minute;                  // 0-59 or SCHEDULE_ANY
+    int8_t hour;                    // 0-23 or SCHEDULE_ANY
+    uint8_t days;                   // Day-of-week bit mask
+    start_data_t start;             // Payload for CMD_START
+    uint8_t target_count;
+    uint8_t targets[SCHEDULER_MAX_TARGETS][6];
+} schedule_entry_t;
+
+esp_err_t scheduler_init(schedule_send_fn_t send_fn, const char *storage_path);
+
+// Add or replace (by id) an entry; id 0 picks the next free id
+esp_err_t scheduler_add(schedule_entry_t *entry);
+esp_err_t scheduler_remove(uint16_t id);
+void scheduler_clear(void);
+
+// Apply a request received on {prefix}/bridge/schedules/<action>
+// Actions: add (object or array), remove ({"id":n}), clear, get
+esp_err_t scheduler_handle_request(const char *action, const char *payload, size_t payload_len);
+
+// Serialize all entries as a JSON array. Caller must release it with cJSON_free.
+char* scheduler_to_json(void);
+
+// Next local time strictly after 'now' at which the entry fires, or 0 if never
+time_t scheduler_next_fire(const schedule_entry_t *entry, time_t now);
+
+#endif // SCHEDULER_H
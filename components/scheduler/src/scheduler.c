@@ -0,0 +1,736 @@
+#include "scheduler.h"
+#include "timer_wheel.h"
+#include "esp_log.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include "cJSON.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <sys/time.h>
+
+#define TAG "SCHEDULER"
+
+#define SCHEDULER_TASK_STACK     4096
+#define SCHEDULER_TASK_PRIORITY  5
+#define SCHEDULER_MIN_VALID_TIME 1577836800  // 2020-01-01, anything earlier means no SNTP yet
+#define SCHEDULER_MAX_CATCHUP    120         // Larger clock jumps re-arm instead of replaying
+#define SCHEDULER_CLOCK_SAVE_S   900         // How often the clock is copied to NVS
+#define SCHEDULER_CLOCK_MAGIC    0x5343484Bu
+#define SCHEDULER_NVS_NAMESPACE  "scheduler"
+#define SCHEDULER_NVS_CLOCK_KEY  "clock"
+#define SCHEDULER_NVS_FIRED_KEY  "fired"
+
+typedef struct {
+    bool used;
+    schedule_entry_t entry;
+    timer_wheel_timer_t timer;
+} schedule_slot_t;
+
+static schedule_slot_t slots[SCHEDULER_MAX_ENTRIES];
+static timer_wheel_t wheel;
+static bool clock_valid = false;
+static SemaphoreHandle_t lock = NULL;
+static schedule_send_fn_t send_function = NULL;
+static char storage_file[64];
+
+// Last known wall clock, to fall back on when booting without SNTP. RTC
+// memory survives software resets and panics; NVS survives power loss but
+// is written only every SCHEDULER_CLOCK_SAVE_S.
+static RTC_NOINIT_ATTR struct {
+    uint32_t magic;
+    int64_t epoch;
+    int64_t fired;             // Copy of last_fired
+} rtc_clock;
+static time_t last_clock_save = 0;
+
+// Wall time of the last dispatched tick, kept in RTC memory and NVS. A clock
+// resumed from an older saved time replays that span, so ticks at or before
+// it are skipped instead of sending the same schedules twice.
+static time_t last_fired = 0;
+
+// Entries due in the current tick, dispatched once the lock is released
+static uint16_t due_ids[SCHEDULER_MAX_ENTRIES];
+static int due_count = 0;
+static time_t due_time = 0;
+
+time_t scheduler_next_fire(const schedule_entry_t *entry, time_t now) {
+    if (!entry || !entry->enabled || (entry->days & SCHEDULE_ALL_DAYS) == 0) {
+        return 0;
+    }
+
+    struct tm today;
+    localtime_r(&now, &today);
+
+    // Eight days so that "today, but earlier than now" wraps to next week
+    for (int day = 0; day < 8; day++) {
+        int wday = (today.tm_wday + day) % 7;
+        if (!(entry->days & (1 << wday))) {
+            continue;
+        }
+
+        int first_hour = (day == 0) ? today.tm_hour : 0;
+        for (int hour = first_hour; hour < 24; hour++) {
+            if (entry->hour != SCHEDULE_ANY && hour != entry->hour) {
+                continue;
+            }
+
+            int first_minute = (day == 0 && hour == today.tm_hour) ? today.tm_min + 1 : 0;
+            int minute;
+            if (entry->minute == SCHEDULE_ANY) {
+                minute = first_minute;
+            } else if (entry->minute >= first_minute) {
+                minute = entry->minute;
+            } else {
+                continue;
+            }
+            if (minute > 59) {
+                continue;
+            }
+
+            struct tm fire = today;
+            fire.tm_mday += day;
+            fire.tm_hour = hour;
+            fire.tm_min = minute;
+            fire.tm_sec = 0;
+            fire.tm_isdst = -1;
+            return mktime(&fire);
+        }
+    }
+
+    return 0;
+}
+
+// Must be called with the lock held
+static void arm_slot(schedule_slot_t *slot, time_t now) {
+    timer_wheel_del(&slot->timer);
+    if (!clock_valid) {
+        return;
+    }
+
+    time_t next = scheduler_next_fire(&slot->entry, now);
+    if (next > 0) {
+        timer_wheel_add(&wheel, &slot->timer, (uint32_t)next);
+    }
+}
+
+static void rearm_all(time_t now) {
+    for (int i = 0; i < SCHEDULER_MAX_ENTRIES; i++) {
+        if (slots[i].used) {
+            // The wheel was reset, so drop any stale list links first
+            timer_wheel_timer_init(&slots[i].timer, slots[i].timer.callback, &slots[i]);
+            arm_slot(&slots[i], now);
+        }
+    }
+}
+
+static void dispatch_entry(const schedule_entry_t *entry) {
+    uint8_t buffer[sizeof(command_packet_t) + sizeof(start_data_t)];
+    command_packet_t *cmd = (command_packet_t *)buffer;
+
+    cmd->command = entry->action;
+    cmd->data_len = 0;
+    if (entry->action == CMD_START) {
+        memcpy(cmd->data, &entry->start, sizeof(start_data_t));
+        cmd->data_len = sizeof(start_data_t);
+    }
+
+    ESP_LOGI(TAG, "Schedule %u firing %s for %u device(s)",
+             entry->id, command_to_str(entry->action), entry->target_count);
+
+    for (int i = 0; i < entry->target_count; i++) {
+        if (send_function) {
+            send_function(entry->targets[i], cmd);
+        }
+    }
+}
+
+static schedule_slot_t* find_slot(uint16_t id) {
+    for (int i = 0; i < SCHEDULER_MAX_ENTRIES; i++) {
+        if (slots[i].used && slots[i].entry.id == id) {
+            return &slots[i];
+        }
+    }
+    return NULL;
+}
+
+// Runs inside the wheel tick with the lock held, so sending is deferred
+static void schedule_fire(timer_wheel_timer_t *timer, void *arg) {
+    schedule_slot_t *slot = (schedule_slot_t *)arg;
+    if ((time_t)wheel.now <= last_fired) {
+        ESP_LOGW(TAG, "Schedule %u already ran at this time before a restart, skipping",
+                 slot->entry.id);
+    } else if (due_count < SCHEDULER_MAX_ENTRIES) {
+        due_ids[due_count++] = slot->entry.id;
+        due_time = (time_t)wheel.now;
+    }
+    arm_slot(slot, (time_t)wheel.now);
+}
+
+static void save_last_fired(time_t fired) {
+    last_fired = fired;
+    rtc_clock.fired = fired;
+
+    nvs_handle_t handle;
+    if (nvs_open(SCHEDULER_NVS_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK) {
+        return;
+    }
+    if (nvs_set_i64(handle, SCHEDULER_NVS_FIRED_KEY, fired) == ESP_OK) {
+        nvs_commit(handle);
+    }
+    nvs_close(handle);
+}
+
+// Sends can be slow, so each runs on a copy without the lock; an entry
+// removed in the meantime is skipped
+static void dispatch_due(void) {
+    if (due_count == 0) {
+        return;
+    }
+    // Recorded first: a restart halfway through must not send the batch again
+    save_last_fired(due_time);
+
+    for (int i = 0; i < due_count; i++) {
+        schedule_entry_t entry;
+        xSemaphoreTake(lock, portMAX_DELAY);
+        schedule_slot_t *slot = find_slot(due_ids[i]);
+        if (slot) {
+            entry = slot->entry;
+        }
+        xSemaphoreGive(lock);
+
+        if (slot) {
+            dispatch_entry(&entry);
+        }
+    }
+    due_count = 0;
+}
+
+static void save_clock(time_t now) {
+    if (rtc_clock.magic != SCHEDULER_CLOCK_MAGIC) {
+        rtc_clock.fired = last_fired;
+    }
+    rtc_clock.epoch = now;
+    rtc_clock.magic = SCHEDULER_CLOCK_MAGIC;
+    if (now - last_clock_save < SCHEDULER_CLOCK_SAVE_S) {
+        return;
+    }
+
+    nvs_handle_t handle;
+    if (nvs_open(SCHEDULER_NVS_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK) {
+        return;
+    }
+    if (nvs_set_i64(handle, SCHEDULER_NVS_CLOCK_KEY, now) == ESP_OK && nvs_commit(handle) == ESP_OK) {
+        last_clock_save = now;
+    }
+    nvs_close(handle);
+}
+
+// Without SNTP, resume from the last known time advanced by the uptime so
+// schedules keep running offline. Time spent powered off is lost, so after
+// a power cut entries run late by that much until SNTP corrects the clock;
+// entries in the replayed span that already ran are skipped via last_fired.
+static void restore_clock(void) {
+    int64_t epoch = 0;
+    int64_t fired = 0;
+    const char *source = "RTC memory";
+    if (rtc_clock.magic == SCHEDULER_CLOCK_MAGIC) {
+        epoch = rtc_clock.epoch;
+        fired = rtc_clock.fired;
+    } else {
+        nvs_handle_t handle;
+        source = "NVS";
+        if (nvs_open(SCHEDULER_NVS_NAMESPACE, NVS_READONLY, &handle) == ESP_OK) {
+            nvs_get_i64(handle, SCHEDULER_NVS_CLOCK_KEY, &epoch);
+            nvs_get_i64(handle, SCHEDULER_NVS_FIRED_KEY, &fired);
+            nvs_close(handle);
+        }
+    }
+    last_fired = (time_t)fired;
+
+    if (time(NULL) >= SCHEDULER_MIN_VALID_TIME) {
+        return;
+    }
+    if (epoch < SCHEDULER_MIN_VALID_TIME) {
+        ESP_LOGW(TAG, "No known time; schedules wait for SNTP");
+        return;
+    }
+
+    struct timeval tv = { .tv_sec = (time_t)(epoch + esp_timer_get_time() / 1000000) };
+    settimeofday(&tv, NULL);
+    ESP_LOGW(TAG, "Clock not set, resuming from the last known time in %s", source);
+}
+
+static void scheduler_task(void *arg) {
+    TickType_t last_wake = xTaskGetTickCount();
+
+    while (1) {
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(1000));
+
+        time_t now = time(NULL);
+        if (now < SCHEDULER_MIN_VALID_TIME) {
+            continue;
+        }
+        save_clock(now);
+
+        xSemaphoreTake(lock, portMAX_DELAY);
+        int32_t drift = (int32_t)((uint32_t)now - wheel.now);
+        if (!clock_valid || drift < 0 || drift > SCHEDULER_MAX_CATCHUP) {
+            if (clock_valid) {
+                ESP_LOGW(TAG, "Clock jumped by %" PRIi32 " s, re-arming schedules", drift);
+            }
+            clock_valid = true;
+            timer_wheel_init(&wheel, (uint32_t)now);
+            rearm_all(now);
+        } else {
+            timer_wheel_advance(&wheel, (uint32_t)now);
+        }
+        xSemaphoreGive(lock);
+
+        dispatch_due();
+    }
+}
+
+// One past the highest id in use; may exceed UINT16_MAX
+static uint32_t next_free_id(void) {
+    uint32_t id = 1;
+    for (int i = 0; i < SCHEDULER_MAX_ENTRIES; i++) {
+        if (slots[i].used && slots[i].entry.id >= id) {
+            id = slots[i].entry.id + 1;
+        }
+    }
+    return id;
+}
+
+static bool entry_is_valid(const schedule_entry_t *entry) {
+    if (entry->action != CMD_START && entry->action != CMD_STOP) {
+        return false;
+    }
+    if (entry->minute < SCHEDULE_ANY || entry->minute > 59) {
+        return false;
+    }
+    if (entry->hour < SCHEDULE_ANY || entry->hour > 23) {
+        return false;
+    }
+    return entry->target_count > 0 && entry->target_count <= SCHEDULER_MAX_TARGETS;
+}
+
+static esp_err_t add_locked(schedule_entry_t *entry) {
+    if (!entry_is_valid(entry)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (entry->id == 0) {
+        uint32_t id = next_free_id();
+        if (id > UINT16_MAX) {
+            return ESP_ERR_NO_MEM;
+        }
+        entry->id = (uint16_t)id;
+    }
+
+    schedule_slot_t *slot = find_slot(entry->id);
+    if (!slot) {
+        for (int i = 0; i < SCHEDULER_MAX_ENTRIES && !slot; i++) {
+            if (!slots[i].used) {
+                slot = &slots[i];
+            }
+        }
+        if (!slot) {
+            ESP_LOGE(TAG, "Schedule table full (%d entries)", SCHEDULER_MAX_ENTRIES);
+            return ESP_ERR_NO_MEM;
+        }
+        timer_wheel_timer_init(&slot->timer, schedule_fire, slot);
+    }
+
+    slot->used = true;
+    slot->entry = *entry;
+    arm_slot(slot, (time_t)wheel.now);
+    return ESP_OK;
+}
+
+// Reads an optional integer field in [min, max]; false if it is present but
+// not such an integer, checked before any narrowing cast
+static bool json_int(const cJSON *object, const char *name, double min, double max,
+                     double fallback, double *value) {
+    const cJSON *item = cJSON_GetObjectItem(object, name);
+    if (!item) {
+        *value = fallback;
+        return true;
+    }
+    if (!cJSON_IsNumber(item) || item->valuedouble != (double)(int64_t)item->valuedouble ||
+        item->valuedouble < min || item->valuedouble > max) {
+        ESP_LOGW(TAG, "Schedule field \"%s\" out of range", name);
+        return false;
+    }
+    *value = item->valuedouble;
+    return true;
+}
+
+static bool entry_from_json(const cJSON *json, schedule_entry_t *entry) {
+    memset(entry, 0, sizeof(*entry));
+
+    const cJSON *action = cJSON_GetObjectItem(json, "action");
+    if (!cJSON_IsString(action)) {
+        return false;
+    }
+    if (strcmp(action->valuestring, "START") == 0) {
+        entry->action = CMD_START;
+    } else if (strcmp(action->valuestring, "STOP") == 0) {
+        entry->action = CMD_STOP;
+    } else {
+        return false;
+    }
+
+    const cJSON *enabled = cJSON_GetObjectItem(json, "enabled");
+    entry->enabled = enabled ? cJSON_IsTrue(enabled) : true;
+    double id, minute, hour, days, duration_sec, valve_control, valve_states;
+    if (!json_int(json, "id", 0, UINT16_MAX, 0, &id) ||
+        !json_int(json, "minute", SCHEDULE_ANY, 59, 0, &minute) ||
+        !json_int(json, "hour", SCHEDULE_ANY, 23, SCHEDULE_ANY, &hour) ||
+        !json_int(json, "days", 0, SCHEDULE_ALL_DAYS, SCHEDULE_ALL_DAYS, &days) ||
+        !json_int(json, "duration_sec", 0, UINT32_MAX, 0, &duration_sec) ||
+        !json_int(json, "valve_control", 0, UINT8_MAX, 0, &valve_control) ||
+        !json_int(json, "valve_states", 0, UINT8_MAX, 0, &valve_states)) {
+        return false;
+    }
+    entry->id = (uint16_t)id;
+    entry->minute = (int8_t)minute;
+    entry->hour = (int8_t)hour;
+    entry->days = (uint8_t)days;
+    entry->start.duration_sec = (uint32_t)duration_sec;
+    entry->start.valve_control = (uint8_t)valve_control;
+    entry->start.valve_states = (uint8_t)valve_states;
+
+    const cJSON *targets = cJSON_GetObjectItem(json, "targets");
+    const cJSON *target;
+    cJSON_ArrayForEach(target, targets) {
+        if (entry->target_count >= SCHEDULER_MAX_TARGETS) {
+            return false;
+        }
+        if (!cJSON_IsString(target) ||
+            !mac_str_to_bytes(target->valuestring, entry->targets[entry->target_count])) {
+            return false;
+        }
+        entry->target_count++;
+    }
+
+    return entry_is_valid(entry);
+}
+
+static cJSON* entry_to_json(const schedule_entry_t *entry) {
+    cJSON *json = cJSON_CreateObject();
+    cJSON_AddNumberToObject(json, "id", entry->id);
+    cJSON_AddBoolToObject(json, "enabled", entry->enabled);
+    cJSON_AddStringToObject(json, "action", command_to_str(entry->action));
+    cJSON_AddNumberToObject(json, "minute", entry->minute);
+    cJSON_AddNumberToObject(json, "hour", entry->hour);
+    cJSON_AddNumberToObject(json, "days", entry->days);
+    if (entry->action == CMD_START) {
+        cJSON_AddNumberToObject(json, "duration_sec", entry->start.duration_sec);
+        cJSON_AddNumberToObject(json, "valve_control", entry->start.valve_control);
+        cJSON_AddNumberToObject(json, "valve_states", entry->start.valve_states);
+    }
+
+    cJSON *targets = cJSON_AddArrayToObject(json, "targets");
+    for (int i = 0; i < entry->target_count; i++) {
+        const uint8_t *mac = entry->targets[i];
+        char mac_str[MAC_STR_LEN];
+        mac_bytes_to_str(mac, mac_str);
+        cJSON_AddItemToArray(targets, cJSON_CreateString(mac_str));
+    }
+    return json;
+}
+
+static char* to_json_locked(void) {
+    cJSON *root = cJSON_CreateArray();
+    for (int i = 0; i < SCHEDULER_MAX_ENTRIES; i++) {
+        if (slots[i].used) {
+            cJSON_AddItemToArray(root, entry_to_json(&slots[i].entry));
+        }
+    }
+    char *json = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+    return json;
+}
+
+static void save_locked(void) {
+    if (storage_file[0] == '\0') {
+        return;
+    }
+
+    char *json = to_json_locked();
+    if (!json) {
+        ESP_LOGE(TAG, "Failed to serialize schedules");
+        return;
+    }
+
+    FILE *f = fopen(storage_file, "w");
+    if (!f) {
+        ESP_LOGE(TAG, "Failed to open %s for writing", storage_file);
+        cJSON_free(json);
+        return;
+    }
+    size_t len = strlen(json);
+    if (fwrite(json, 1, len, f) != len) {
+        ESP_LOGE(TAG, "Failed to write %s", storage_file);
+    }
+    fclose(f);
+    cJSON_free(json);
+}
+
+// All entries of an "add" array or none: every entry is parsed and the
+// table checked for room before anything changes
+static esp_err_t add_all_locked(const cJSON *root) {
+    int count = cJSON_GetArraySize(root);
+    if (count > SCHEDULER_MAX_ENTRIES) {
+        return ESP_ERR_NO_MEM;
+    }
+    schedule_entry_t *entries = malloc((count > 0 ? count : 1) * sizeof(schedule_entry_t));
+    if (!entries) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_err_t err = ESP_OK;
+    uint32_t next_id = next_free_id();
+    int index = 0;
+    const cJSON *item;
+    cJSON_ArrayForEach(item, root) {
+        if (!entry_from_json(item, &entries[index])) {
+            ESP_LOGW(TAG, "Schedule entry %d is invalid, nothing added", index);
+            err = ESP_ERR_INVALID_ARG;
+            break;
+        }
+        if (entries[index].id >= next_id) {
+            next_id = entries[index].id + 1;
+        }
+        index++;
+    }
+
+    // Pick ids for id-0 entries up front, past every explicit id of the batch,
+    // so a later entry cannot replace one of them
+    int needed = 0;
+    for (int i = 0; i < count && err == ESP_OK; i++) {
+        if (entries[i].id == 0) {
+            if (next_id > UINT16_MAX) {
+                err = ESP_ERR_NO_MEM;
+                break;
+            }
+            entries[i].id = (uint16_t)next_id++;
+        }
+        // New ids take a slot, unless an earlier entry of the batch has the same id
+        bool duplicate = false;
+        for (int j = 0; j < i; j++) {
+            duplicate |= entries[j].id == entries[i].id;
+        }
+        if (!duplicate && !find_slot(entries[i].id)) {
+            needed++;
+        }
+    }
+
+    int free_slots = 0;
+    for (int i = 0; i < SCHEDULER_MAX_ENTRIES; i++) {
+        free_slots += !slots[i].used;
+    }
+    if (err == ESP_OK && needed > free_slots) {
+        ESP_LOGE(TAG, "%d new schedules do not fit in %d free slots, nothing added", needed, free_slots);
+        err = ESP_ERR_NO_MEM;
+    }
+
+    for (int i = 0; i < count && err == ESP_OK; i++) {
+        err = add_locked(&entries[i]);
+    }
+    free(entries);
+    return err;
+}
+
+static int load_json_locked(const cJSON *root) {
+    int loaded = 0;
+    const cJSON *item;
+    cJSON_ArrayForEach(item, root) {
+        schedule_entry_t entry;
+        if (entry_from_json(item, &entry) && add_locked(&entry) == ESP_OK) {
+            loaded++;
+        } else {
+            ESP_LOGW(TAG, "Skipping invalid schedule entry");
+        }
+    }
+    return loaded;
+}
+
+static void load_from_storage(void) {
+    FILE *f = fopen(storage_file, "r");
+    if (!f) {
+        ESP_LOGI(TAG, "No stored schedules at %s", storage_file);
+        return;
+    }
+
+    fseek(f, 0, SEEK_END);
+    long fsize = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    if (fsize <= 0) {
+        fclose(f);
+        return;
+    }
+
+    char *json_str = malloc(fsize + 1);
+    if (!json_str) {
+        ESP_LOGE(TAG, "Memory allocation failed");
+        fclose(f);
+        return;
+    }
+    size_t read = fread(json_str, 1, fsize, f);
+    fclose(f);
+    json_str[read] = '\0';
+
+    cJSON *root = cJSON_Parse(json_str);
+    free(json_str);
+    if (!cJSON_IsArray(root)) {
+        ESP_LOGE(TAG, "Stored schedules are corrupt, ignoring");
+        cJSON_Delete(root);
+        return;
+    }
+
+    int loaded = load_json_locked(root);
+    cJSON_Delete(root);
+    ESP_LOGI(TAG, "Loaded %d schedule(s) from %s", loaded, storage_file);
+}
+
+esp_err_t scheduler_init(schedule_send_fn_t send_fn, const char *storage_path) {
+    if (lock != NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    send_function = send_fn;
+    storage_file[0] = '\0';
+    if (storage_path) {
+        strncpy(storage_file, storage_path, sizeof(storage_file) - 1);
+        storage_file[sizeof(storage_file) - 1] = '\0';
+    }
+
+    lock = xSemaphoreCreateMutex();
+    if (!lock) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    memset(slots, 0, sizeof(slots));
+    timer_wheel_init(&wheel, 0);
+    restore_clock();
+    if (storage_file[0] != '\0') {
+        load_from_storage();
+    }
+
+    if (xTaskCreate(scheduler_task, "scheduler", SCHEDULER_TASK_STACK, NULL,
+                    SCHEDULER_TASK_PRIORITY, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create scheduler task");
+        return ESP_FAIL;
+    }
+
+    ESP_LOGI(TAG, "Scheduler initialized (capacity %d entries)", SCHEDULER_MAX_ENTRIES);
+    return ESP_OK;
+}
+
+esp_err_t scheduler_add(schedule_entry_t *entry) {
+    if (!entry || !lock) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    esp_err_t err = add_locked(entry);
+    if (err == ESP_OK) {
+        save_locked();
+    }
+    xSemaphoreGive(lock);
+    return err;
+}
+
+esp_err_t scheduler_remove(uint16_t id) {
+    if (!lock) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    schedule_slot_t *slot = find_slot(id);
+    if (slot) {
+        timer_wheel_del(&slot->timer);
+        slot->used = false;
+        save_locked();
+    }
+    xSemaphoreGive(lock);
+    return slot ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+void scheduler_clear(void) {
+    if (!lock) {
+        return;
+    }
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    for (int i = 0; i < SCHEDULER_MAX_ENTRIES; i++) {
+        if (slots[i].used) {
+            timer_wheel_del(&slots[i].timer);
+            slots[i].used = false;
+        }
+    }
+    save_locked();
+    xSemaphoreGive(lock);
+}
+
+char* scheduler_to_json(void) {
+    if (!lock) {
+        return NULL;
+    }
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    char *json = to_json_locked();
+    xSemaphoreGive(lock);
+    return json;
+}
+
+esp_err_t scheduler_handle_request(const char *action, const char *payload, size_t payload_len) {
+    if (!action || !lock) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (strcmp(action, "get") == 0) {
+        return ESP_OK;
+    }
+    if (strcmp(action, "clear") == 0) {
+        scheduler_clear();
+        return ESP_OK;
+    }
+
+    cJSON *root = payload ? cJSON_ParseWithLength(payload, payload_len) : NULL;
+    if (!root) {
+        ESP_LOGE(TAG, "Invalid JSON for schedules/%s", action);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t err = ESP_OK;
+    if (strcmp(action, "add") == 0) {
+        xSemaphoreTake(lock, portMAX_DELAY);
+        if (cJSON_IsArray(root)) {
+            err = add_all_locked(root);
+        } else {
+            schedule_entry_t entry;
+            err = entry_from_json(root, &entry) ? add_locked(&entry) : ESP_ERR_INVALID_ARG;
+        }
+        if (err == ESP_OK) {
+            save_locked();
+        }
+        xSemaphoreGive(lock);
+    } else if (strcmp(action, "remove") == 0) {
+        const cJSON *id = cJSON_IsNumber(root) ? root : cJSON_GetObjectItem(root, "id");
+        bool valid = cJSON_IsNumber(id) && id->valuedouble >= 1 && id->valuedouble <= UINT16_MAX;
+        err = valid ? scheduler_remove((uint16_t)id->valuedouble) : ESP_ERR_INVALID_ARG;
+    } else {
+        ESP_LOGW(TAG, "Unknown schedules action: %s", action);
+        err = ESP_ERR_NOT_SUPPORTED;
+    }
+
+    cJSON_Delete(root);
+    return err;
+}
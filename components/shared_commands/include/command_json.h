@@ -0,0 +1,43 @@
+#ifndef COMMAND_JSON_H
+#define COMMAND_JSON_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "shared_commands.h"
+
+#define COMMAND_JSON_MAX_LEN        255  // Matches the MQTT command payload buffer
+#define COMMAND_JSON_MAX_TOKENS     32   // Keys and values, nested ones included
+#define COMMAND_JSON_MAX_DEPTH      4
+
+// Bits of command_json_t.fields
+#define COMMAND_FIELD_REQUEST_ID    (1u << 0)
+#define COMMAND_FIELD_DURATION      (1u << 1)
+#define COMMAND_FIELD_VALVE_CONTROL (1u << 2)
+#define COMMAND_FIELD_VALVE_STATES  (1u << 3)
+#define COMMAND_FIELD_DEVICE_TIME   (1u << 4)
+#define COMMAND_FIELD_BATTERY_SOC   (1u << 5)
+
+typedef struct {
+    uint32_t fields;           // COMMAND_FIELD_* seen in the payload
+    uint32_t request_id;
+    union {
+        start_data_t start;
+        sync_data_t sync;
+    } data;
+    uint8_t data_len;          // Bytes of 'data' that make up the ESP-NOW payload
+} command_json_t;
+
+// Parse an MQTT command payload in a single pass without allocating. The
+// documented fields for 'cmd' go straight into the packed ESP-NOW payload
+// struct; "request_id" is accepted for every command and other keys are
+// skipped. START needs "duration_sec" (optional "valve_control" and
+// "valve_states" bitmaps), SYNC needs "device_time" (optional "battery_soc").
+// An empty payload yields no fields and no data.
+//
+// Returns ESP_OK, ESP_ERR_INVALID_ARG for malformed JSON or duplicate,
+// mistyped or out-of-range fields, ESP_ERR_INVALID_SIZE past the length,
+// token or nesting budget, or ESP_ERR_NOT_FOUND when a required field is missing.
+esp_err_t command_json_parse(command_type_t cmd, const char* json, size_t len, command_json_t* out);
+
+#endif // COMMAND_JSON_H
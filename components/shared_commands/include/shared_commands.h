@@ -9,6 +9,7 @@
 
 // Command types
 typedef enum {
+    CMD_INVALID = 0x00,  // Returned by str_to_command for unknown names
     CMD_SYNC = 0x01,
     CMD_START = 0x02,
     CMD_STOP = 0x03,
@@ -82,8 +83,30 @@ typedef struct __attribute__((packed)) {
     uint8_t valve_states;    // Bit field for valve states
 } status_response_t;
 
+#define MAC_STR_LEN 18  // "aa:bb:cc:dd:ee:ff" plus terminator
+
 // Helper functions
 const char* command_to_str(command_type_t cmd);
 command_type_t str_to_command(const char* str);
 
+// Check that a received frame holds a complete command packet
+bool command_packet_validate(const uint8_t* data, int len);
+
+// Strict "aa:bb:cc:dd:ee:ff" parsing (exactly 17 characters, any hex case)
+bool mac_str_to_bytes(const char* str, uint8_t mac[6]);
+void mac_bytes_to_str(const uint8_t mac[6], char str[MAC_STR_LEN]);
+
+// Lowercase hex; 'out' needs room for 2 * len + 1 characters
+void hex_encode(const uint8_t* data, size_t len, char* out);
+// Returns the decoded length, or -1 on odd length, bad digits or overflow
+int hex_decode(const char* hex, uint8_t* out, size_t out_size);
+
+#define VARINT_MAX_LEN 10  // Bytes for a uint64_t
+
+// LEB128: 7 bits per byte, low bits first. Returns the bytes written, or 0
+// if 'out_size' is too small.
+size_t varint_encode(uint64_t value, uint8_t* out, size_t out_size);
+// Returns the bytes consumed, or 0 when truncated or longer than VARINT_MAX_LEN
+size_t varint_decode(const uint8_t* data, size_t len, uint64_t* value);
+
 #endif /* SHARED_COMMANDS_H */
@@ -0,0 +1,62 @@
+#ifndef WIRE_FORMAT_H
+#define WIRE_FORMAT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
+#include "esp_err.h"
+#include "shared_commands.h"
+
+// Compact v2 ESP-NOW frames. The bridge works with v1 command_packet_t
+// internally and converts at the radio for devices that speak v2.
+//
+//   byte 0   0b01vv_ffff: marker (never a v1 command byte), version - 2, flags
+//   byte 1   command
+//   data     per command, to the end of the frame (no length byte); never
+//            longer than the v1 packet:
+//     SYNC             time, soc
+//     SYNC response    time
+//     START            varint duration_sec, valve_control | valve_states << 3
+//     STATUS response  time, soc, valve_states | pump_state << 3
+//     anything else    the v1 data bytes (WIRE_FLAG_RAW)
+//
+// time: a varint of the absolute time, or in a STATUS response with
+// WIRE_FLAG_DELTA_TIME, a tag byte (low byte of the time base) and a varint of
+// seconds since the base. The base is the time carried by the last SYNC or
+// SYNC response the bridge delivered to the device; those are always absolute.
+// soc:  one byte in 0.5 % steps (0-200), WIRE_SOC_UNKNOWN when out of range.
+#define WIRE_MARKER             0x40
+#define WIRE_MARKER_MASK        0xC0
+#define WIRE_VERSION_SHIFT      4
+#define WIRE_VERSION_MASK       0x30
+#define WIRE_FLAG_DELTA_TIME    0x01
+#define WIRE_FLAG_RAW           0x02
+#define WIRE_FLAGS_KNOWN        (WIRE_FLAG_DELTA_TIME | WIRE_FLAG_RAW)
+
+#define WIRE_VERSION_V1         1
+#define WIRE_VERSION_V2         2
+#define WIRE_SOC_UNKNOWN        0xFF
+#define WIRE_MAX_FRAME          250   // ESP_NOW_MAX_DATA_LEN
+
+typedef struct {
+    bool valid;
+    time_t time;
+} wire_time_base_t;
+
+// Version of a received frame, judged by its first byte
+int wire_frame_version(const uint8_t *data, size_t len);
+
+// Encode a v1 packet as v2. Returns the frame length, or 0 when it does not fit.
+size_t wire_encode_v2(const command_packet_t *cmd, const wire_time_base_t *base,
+                      uint8_t *out, size_t out_size);
+
+// Decode a v2 frame into a v1 packet of at most 'out_size' bytes and store
+// its length in 'out_len'. Returns ESP_ERR_INVALID_ARG for malformed frames
+// and ESP_ERR_INVALID_STATE when a delta time refers to a base we do not hold.
+esp_err_t wire_decode_v2(const uint8_t *data, size_t len, const wire_time_base_t *base,
+                         command_packet_t *out, size_t out_size, size_t *out_len);
+
+uint8_t wire_quantize_soc(float soc);
+float wire_dequantize_soc(uint8_t q);  // -1 for WIRE_SOC_UNKNOWN
+
+#endif // WIRE_FORMAT_H
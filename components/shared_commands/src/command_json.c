@@ -0,0 +1,396 @@
+#include "command_json.h"
+#include <stddef.h>
+#include <string.h>
+
+typedef enum {
+    FIELD_UINT32,
+    FIELD_UINT8,
+    FIELD_TIME,
+    FIELD_SOC
+} field_kind_t;
+
+typedef struct {
+    const char* name;
+    uint8_t name_len;
+    command_type_t cmd;        // CMD_INVALID for fields every command accepts
+    uint32_t bit;
+    field_kind_t kind;
+    size_t offset;             // Destination within command_json_t
+} field_t;
+
+#define FIELD(name, cmd, bit, kind, member) \
+    {name, sizeof(name) - 1, cmd, bit, kind, offsetof(command_json_t, member)}
+
+static const field_t fields[] = {
+    FIELD("request_id",    CMD_INVALID, COMMAND_FIELD_REQUEST_ID,    FIELD_UINT32, request_id),
+    FIELD("duration_sec",  CMD_START,   COMMAND_FIELD_DURATION,      FIELD_UINT32, data.start.duration_sec),
+    FIELD("valve_control", CMD_START,   COMMAND_FIELD_VALVE_CONTROL, FIELD_UINT8,  data.start.valve_control),
+    FIELD("valve_states",  CMD_START,   COMMAND_FIELD_VALVE_STATES,  FIELD_UINT8,  data.start.valve_states),
+    FIELD("device_time",   CMD_SYNC,    COMMAND_FIELD_DEVICE_TIME,   FIELD_TIME,   data.sync.device_time),
+    FIELD("battery_soc",   CMD_SYNC,    COMMAND_FIELD_BATTERY_SOC,   FIELD_SOC,    data.sync.battery_soc),
+};
+
+#define FIELD_COUNT (int)(sizeof(fields) / sizeof(fields[0]))
+
+typedef struct {
+    const char* p;
+    const char* end;
+    int tokens;
+} scanner_t;
+
+#define TRY(expr) do { esp_err_t err_ = (expr); if (err_ != ESP_OK) return err_; } while (0)
+
+static void skip_ws(scanner_t* s) {
+    while (s->p < s->end && (*s->p == ' ' || *s->p == '\t' || *s->p == '\n' || *s->p == '\r')) {
+        s->p++;
+    }
+}
+
+static esp_err_t take_token(scanner_t* s) {
+    return ++s->tokens > COMMAND_JSON_MAX_TOKENS ? ESP_ERR_INVALID_SIZE : ESP_OK;
+}
+
+static esp_err_t expect(scanner_t* s, char c) {
+    skip_ws(s);
+    if (s->p >= s->end || *s->p != c) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s->p++;
+    return ESP_OK;
+}
+
+static bool is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+// Scan a string starting at its opening quote; 'start'/'len' span the raw
+// contents and 'escaped' tells whether they differ from the decoded text
+static esp_err_t scan_string(scanner_t* s, const char** start, size_t* len, bool* escaped) {
+    TRY(take_token(s));
+    s->p++;
+    *start = s->p;
+    *escaped = false;
+    while (s->p < s->end) {
+        unsigned char c = (unsigned char)*s->p++;
+        if (c == '"') {
+            *len = (size_t)(s->p - 1 - *start);
+            return ESP_OK;
+        }
+        if (c < 0x20) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        if (c != '\\') {
+            continue;
+        }
+
+        *escaped = true;
+        if (s->p >= s->end) {
+            break;
+        }
+        c = (unsigned char)*s->p++;
+        if (c == 'u') {
+            for (int i = 0; i < 4; i++, s->p++) {
+                char h = s->p < s->end ? *s->p : '\0';
+                if (!is_digit(h) && !((h | 0x20) >= 'a' && (h | 0x20) <= 'f')) {
+                    return ESP_ERR_INVALID_ARG;
+                }
+            }
+        } else if (!strchr("\"\\/bfnrt", c) || c == '\0') {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+    return ESP_ERR_INVALID_ARG;
+}
+
+// Scan a number per the JSON grammar, leaving 'start'/'len' on its text
+static esp_err_t scan_number(scanner_t* s, const char** start, size_t* len) {
+    TRY(take_token(s));
+    *start = s->p;
+    if (s->p < s->end && *s->p == '-') {
+        s->p++;
+    }
+    if (s->p >= s->end || !is_digit(*s->p)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (*s->p++ != '0') {
+        while (s->p < s->end && is_digit(*s->p)) {
+            s->p++;
+        }
+    }
+    if (s->p < s->end && *s->p == '.') {
+        s->p++;
+        if (s->p >= s->end || !is_digit(*s->p)) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        while (s->p < s->end && is_digit(*s->p)) {
+            s->p++;
+        }
+    }
+    if (s->p < s->end && (*s->p == 'e' || *s->p == 'E')) {
+        s->p++;
+        if (s->p < s->end && (*s->p == '+' || *s->p == '-')) {
+            s->p++;
+        }
+        if (s->p >= s->end || !is_digit(*s->p)) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        while (s->p < s->end && is_digit(*s->p)) {
+            s->p++;
+        }
+    }
+    *len = (size_t)(s->p - *start);
+    return ESP_OK;
+}
+
+static esp_err_t skip_value(scanner_t* s, int depth);
+
+static esp_err_t skip_container(scanner_t* s, int depth, char close) {
+    if (depth >= COMMAND_JSON_MAX_DEPTH) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    TRY(take_token(s));
+    s->p++;
+    skip_ws(s);
+    if (s->p < s->end && *s->p == close) {
+        s->p++;
+        return ESP_OK;
+    }
+
+    while (1) {
+        if (close == '}') {
+            skip_ws(s);
+            if (s->p >= s->end || *s->p != '"') {
+                return ESP_ERR_INVALID_ARG;
+            }
+            const char* key;
+            size_t key_len;
+            bool escaped;
+            TRY(scan_string(s, &key, &key_len, &escaped));
+            TRY(expect(s, ':'));
+        }
+        TRY(skip_value(s, depth + 1));
+        skip_ws(s);
+        if (s->p >= s->end) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        char c = *s->p++;
+        if (c == close) {
+            return ESP_OK;
+        }
+        if (c != ',') {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+}
+
+static esp_err_t skip_literal(scanner_t* s, const char* word) {
+    size_t len = strlen(word);
+    if ((size_t)(s->end - s->p) < len || memcmp(s->p, word, len) != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s->p += len;
+    return take_token(s);
+}
+
+static esp_err_t skip_value(scanner_t* s, int depth) {
+    skip_ws(s);
+    if (s->p >= s->end) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const char* start;
+    size_t len;
+    bool escaped;
+    switch (*s->p) {
+        case '{': return skip_container(s, depth, '}');
+        case '[': return skip_container(s, depth, ']');
+        case '"': return scan_string(s, &start, &len, &escaped);
+        case 't': return skip_literal(s, "true");
+        case 'f': return skip_literal(s, "false");
+        case 'n': return skip_literal(s, "null");
+        default:  return scan_number(s, &start, &len);
+    }
+}
+
+// Plain non-negative integer text (no sign, fraction or exponent) up to 'max'
+static bool to_uint(const char* text, size_t len, uint64_t max, uint64_t* value) {
+    uint64_t v = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (!is_digit(text[i])) {
+            return false;
+        }
+        uint64_t digit = (uint64_t)(text[i] - '0');
+        if (v > (max - digit) / 10) {
+            return false;
+        }
+        v = v * 10 + digit;
+    }
+    *value = v;
+    return len > 0;
+}
+
+// Percentage 0-100 with an optional fraction
+static bool to_soc(const char* text, size_t len, float* value) {
+    size_t i = 0;
+    uint64_t whole = 0;
+    float scale = 0.1f;
+    float fraction = 0.0f;
+    for (; i < len && is_digit(text[i]); i++) {
+        whole = whole * 10 + (uint64_t)(text[i] - '0');
+        if (whole > 100) {
+            return false;
+        }
+    }
+    if (i < len && text[i] == '.') {
+        for (i++; i < len && is_digit(text[i]); i++) {
+            fraction += (float)(text[i] - '0') * scale;
+            scale *= 0.1f;
+        }
+    }
+    if (i != len || (whole == 100 && fraction > 0.0f)) {
+        return false;
+    }
+    *value = (float)whole + fraction;
+    return true;
+}
+
+// Range-check the number text for the field's type and write it in place;
+// memcpy because the payload structs are packed
+static esp_err_t store_field(const field_t* field, const char* text, size_t len, command_json_t* out) {
+    uint8_t* dest = (uint8_t*)out + field->offset;
+    uint64_t value;
+    switch (field->kind) {
+        case FIELD_UINT32: {
+            if (!to_uint(text, len, UINT32_MAX, &value)) {
+                return ESP_ERR_INVALID_ARG;
+            }
+            uint32_t v = (uint32_t)value;
+            memcpy(dest, &v, sizeof(v));
+            break;
+        }
+        case FIELD_UINT8:
+            if (!to_uint(text, len, UINT8_MAX, &value)) {
+                return ESP_ERR_INVALID_ARG;
+            }
+            *dest = (uint8_t)value;
+            break;
+        case FIELD_TIME: {
+            if (!to_uint(text, len, sizeof(time_t) >= 8 ? INT64_MAX : INT32_MAX, &value)) {
+                return ESP_ERR_INVALID_ARG;
+            }
+            time_t v = (time_t)value;
+            memcpy(dest, &v, sizeof(v));
+            break;
+        }
+        case FIELD_SOC: {
+            float v;
+            if (!to_soc(text, len, &v)) {
+                return ESP_ERR_INVALID_ARG;
+            }
+            memcpy(dest, &v, sizeof(v));
+            break;
+        }
+    }
+    out->fields |= field->bit;
+    return ESP_OK;
+}
+
+static const field_t* find_field(command_type_t cmd, const char* key, size_t len) {
+    for (int i = 0; i < FIELD_COUNT; i++) {
+        const field_t* field = &fields[i];
+        if ((field->cmd == CMD_INVALID || field->cmd == cmd) &&
+            field->name_len == len && memcmp(field->name, key, len) == 0) {
+            return field;
+        }
+    }
+    return NULL;
+}
+
+static esp_err_t parse_object(scanner_t* s, command_type_t cmd, command_json_t* out) {
+    TRY(expect(s, '{'));
+    TRY(take_token(s));
+    skip_ws(s);
+    if (s->p < s->end && *s->p == '}') {
+        s->p++;
+        return ESP_OK;
+    }
+
+    while (1) {
+        skip_ws(s);
+        if (s->p >= s->end || *s->p != '"') {
+            return ESP_ERR_INVALID_ARG;
+        }
+        const char* key;
+        size_t key_len;
+        bool escaped;
+        TRY(scan_string(s, &key, &key_len, &escaped));
+        TRY(expect(s, ':'));
+
+        // Keys spelled with escapes never name a field
+        const field_t* field = escaped ? NULL : find_field(cmd, key, key_len);
+        if (field) {
+            if (out->fields & field->bit) {
+                return ESP_ERR_INVALID_ARG;
+            }
+            skip_ws(s);
+            const char* text;
+            size_t text_len;
+            TRY(scan_number(s, &text, &text_len));
+            TRY(store_field(field, text, text_len, out));
+        } else {
+            TRY(skip_value(s, 1));
+        }
+
+        skip_ws(s);
+        if (s->p >= s->end) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        char c = *s->p++;
+        if (c == '}') {
+            return ESP_OK;
+        }
+        if (c != ',') {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+}
+
+esp_err_t command_json_parse(command_type_t cmd, const char* json, size_t len, command_json_t* out) {
+    if (!out || (!json && len > 0)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(out, 0, sizeof(*out));
+    if (len > COMMAND_JSON_MAX_LEN) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    scanner_t s = { .p = json, .end = json + len, .tokens = 0 };
+    skip_ws(&s);
+    if (s.p == s.end) {
+        return ESP_OK;
+    }
+
+    TRY(parse_object(&s, cmd, out));
+    skip_ws(&s);
+    if (s.p != s.end) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    switch (cmd) {
+        case CMD_START:
+            if (!(out->fields & COMMAND_FIELD_DURATION)) {
+                return ESP_ERR_NOT_FOUND;
+            }
+            out->data_len = sizeof(start_data_t);
+            break;
+        case CMD_SYNC:
+            if (!(out->fields & COMMAND_FIELD_DEVICE_TIME)) {
+                return ESP_ERR_NOT_FOUND;
+            }
+            out->data_len = sizeof(sync_data_t);
+            break;
+        default:
+            break;
+    }
+    return ESP_OK;
+}
@@ -15,7 +15,7 @@ const char* command_to_str(command_type_t cmd) {
 }
 
 command_type_t str_to_command(const char* str) {
-    if (!str) return CMD_SYNC;
+    if (!str) return CMD_INVALID;
     
     if (strcmp(str, "SYNC") == 0) return CMD_SYNC;
     if (strcmp(str, "START") == 0) return CMD_START;
@@ -24,7 +24,107 @@ command_type_t str_to_command(const char* str) {
     if (strcmp(str, "RESPONSE") == 0) return CMD_RESPONSE;
     
     ESP_LOGW(TAG, "Unknown command string: %s", str);
-    return CMD_SYNC;
+    return CMD_INVALID;
+}
+
+bool command_packet_validate(const uint8_t* data, int len) {
+    if (!data || len < (int)sizeof(command_packet_t)) {
+        return false;
+    }
+    const command_packet_t* cmd = (const command_packet_t*)data;
+    return len >= (int)sizeof(command_packet_t) + cmd->data_len;
+}
+
+// Nibble value plus one for every byte; 0 marks non-hex characters
+static const uint8_t hex_table[256] = {
+    ['0'] = 1, ['1'] = 2, ['2'] = 3, ['3'] = 4, ['4'] = 5,
+    ['5'] = 6, ['6'] = 7, ['7'] = 8, ['8'] = 9, ['9'] = 10,
+    ['a'] = 11, ['b'] = 12, ['c'] = 13, ['d'] = 14, ['e'] = 15, ['f'] = 16,
+    ['A'] = 11, ['B'] = 12, ['C'] = 13, ['D'] = 14, ['E'] = 15, ['F'] = 16,
+};
+
+#define HEX_VALUE(c) (hex_table[(unsigned char)(c)] - 1)
+
+static const char hex_digits[] = "0123456789abcdef";
+
+bool mac_str_to_bytes(const char* str, uint8_t mac[6]) {
+    if (!str || !mac) {
+        return false;
+    }
+    for (int i = 0; i < 6; i++) {
+        const unsigned char* pair = (const unsigned char*)str + i * 3;
+        int hi = HEX_VALUE(pair[0]);
+        // A NUL in either digit fails here, so reads never pass the terminator
+        int lo = hi < 0 ? -1 : HEX_VALUE(pair[1]);
+        char separator = i < 5 ? ':' : '\0';
+        if (lo < 0 || pair[2] != separator) {
+            return false;
+        }
+        mac[i] = (uint8_t)((hi << 4) | lo);
+    }
+    return true;
+}
+
+void mac_bytes_to_str(const uint8_t mac[6], char str[MAC_STR_LEN]) {
+    for (int i = 0; i < 6; i++) {
+        str[i * 3] = hex_digits[mac[i] >> 4];
+        str[i * 3 + 1] = hex_digits[mac[i] & 0x0F];
+        str[i * 3 + 2] = ':';
+    }
+    str[MAC_STR_LEN - 1] = '\0';
+}
+
+void hex_encode(const uint8_t* data, size_t len, char* out) {
+    for (size_t i = 0; i < len; i++) {
+        out[i * 2] = hex_digits[data[i] >> 4];
+        out[i * 2 + 1] = hex_digits[data[i] & 0x0F];
+    }
+    out[len * 2] = '\0';
+}
+
+int hex_decode(const char* hex, uint8_t* out, size_t out_size) {
+    size_t len = strlen(hex);
+    if (len % 2 != 0 || len / 2 > out_size) {
+        return -1;
+    }
+    for (size_t i = 0; i < len / 2; i++) {
+        int hi = HEX_VALUE(hex[i * 2]);
+        int lo = HEX_VALUE(hex[i * 2 + 1]);
+        if (hi < 0 || lo < 0) {
+            return -1;
+        }
+        out[i] = (uint8_t)((hi << 4) | lo);
+    }
+    return (int)(len / 2);
+}
+
+size_t varint_encode(uint64_t value, uint8_t* out, size_t out_size) {
+    size_t len = 0;
+    do {
+        if (len >= out_size) {
+            return 0;
+        }
+        uint8_t byte = value & 0x7F;
+        value >>= 7;
+        out[len++] = byte | (value ? 0x80 : 0);
+    } while (value);
+    return len;
+}
+
+size_t varint_decode(const uint8_t* data, size_t len, uint64_t* value) {
+    uint64_t result = 0;
+    for (size_t i = 0; i < len && i < VARINT_MAX_LEN; i++) {
+        // The tenth byte holds the top bit only
+        if (i == VARINT_MAX_LEN - 1 && data[i] > 1) {
+            return 0;
+        }
+        result |= (uint64_t)(data[i] & 0x7F) << (7 * i);
+        if (!(data[i] & 0x80)) {
+            *value = result;
+            return i + 1;
+        }
+    }
+    return 0;
 }
 
 // Helper to convert valve states to bitfield
@@ -0,0 +1,312 @@
+#include "wire_format.h"
+#include <string.h>
+
+#define V2_HEADER_LEN   2
+#define VALVE_MASK      0x07
+#define PUMP_MASK       0x03
+
+typedef enum {
+    SCHEMA_RAW,
+    SCHEMA_SYNC,
+    SCHEMA_SYNC_RESPONSE,
+    SCHEMA_START,
+    SCHEMA_STATUS_RESPONSE
+} schema_t;
+
+// Compact layout for a command, given the v1 data length it carries
+static schema_t schema_for(uint8_t command, size_t data_len) {
+    switch (command) {
+        case CMD_SYNC:
+            return data_len == sizeof(sync_data_t) ? SCHEMA_SYNC : SCHEMA_RAW;
+        case CMD_SYNC | CMD_RESPONSE:
+            return data_len == sizeof(sync_response_t) ? SCHEMA_SYNC_RESPONSE : SCHEMA_RAW;
+        case CMD_START:
+            return data_len == sizeof(start_data_t) ? SCHEMA_START : SCHEMA_RAW;
+        case CMD_STATUS | CMD_RESPONSE:
+            return data_len == sizeof(status_response_t) ? SCHEMA_STATUS_RESPONSE : SCHEMA_RAW;
+        default:
+            return SCHEMA_RAW;
+    }
+}
+
+// Which schema a v2 frame uses is implied by its command unless flagged raw
+static schema_t schema_for_v2(uint8_t command) {
+    switch (command) {
+        case CMD_SYNC: return SCHEMA_SYNC;
+        case CMD_SYNC | CMD_RESPONSE: return SCHEMA_SYNC_RESPONSE;
+        case CMD_START: return SCHEMA_START;
+        case CMD_STATUS | CMD_RESPONSE: return SCHEMA_STATUS_RESPONSE;
+        default: return SCHEMA_RAW;
+    }
+}
+
+int wire_frame_version(const uint8_t *data, size_t len) {
+    if (len == 0) {
+        return 0;
+    }
+    if ((data[0] & WIRE_MARKER_MASK) != WIRE_MARKER) {
+        return WIRE_VERSION_V1;
+    }
+    return WIRE_VERSION_V2 + ((data[0] & WIRE_VERSION_MASK) >> WIRE_VERSION_SHIFT);
+}
+
+uint8_t wire_quantize_soc(float soc) {
+    if (!(soc >= 0.0f && soc <= 100.0f)) {
+        return WIRE_SOC_UNKNOWN;
+    }
+    return (uint8_t)(soc * 2.0f + 0.5f);
+}
+
+float wire_dequantize_soc(uint8_t q) {
+    return q > 200 ? -1.0f : q / 2.0f;
+}
+
+// Writer that fails sticky once 'out' is full
+typedef struct {
+    uint8_t *out;
+    size_t size;
+    size_t pos;
+    bool overflow;
+} writer_t;
+
+static void put_byte(writer_t *w, uint8_t byte) {
+    if (w->pos < w->size) {
+        w->out[w->pos++] = byte;
+    } else {
+        w->overflow = true;
+    }
+}
+
+static void put_varint(writer_t *w, uint64_t value) {
+    size_t n = w->overflow ? 0 : varint_encode(value, w->out + w->pos, w->size - w->pos);
+    if (n == 0) {
+        w->overflow = true;
+    }
+    w->pos += n;
+}
+
+// Returns false if the time cannot be carried compactly (negative)
+static bool put_time(writer_t *w, time_t t, const wire_time_base_t *base, uint8_t *flags) {
+    if (t < 0) {
+        return false;
+    }
+    if (base && base->valid && t >= base->time) {
+        *flags |= WIRE_FLAG_DELTA_TIME;
+        put_byte(w, (uint8_t)base->time);
+        put_varint(w, (uint64_t)(t - base->time));
+    } else {
+        put_varint(w, (uint64_t)t);
+    }
+    return true;
+}
+
+size_t wire_encode_v2(const command_packet_t *cmd, const wire_time_base_t *base,
+                      uint8_t *out, size_t out_size) {
+    writer_t w = { .out = out, .size = out_size };
+    uint8_t flags = 0;
+    put_byte(&w, WIRE_MARKER);
+    put_byte(&w, cmd->command);
+
+    schema_t schema = schema_for(cmd->command, cmd->data_len);
+    bool compact = true;
+    switch (schema) {
+        case SCHEMA_SYNC: {
+            sync_data_t sync;
+            memcpy(&sync, cmd->data, sizeof(sync));
+            compact = put_time(&w, sync.device_time, NULL, &flags);
+            put_byte(&w, wire_quantize_soc(sync.battery_soc));
+            break;
+        }
+        case SCHEMA_SYNC_RESPONSE: {
+            sync_response_t reply;
+            memcpy(&reply, cmd->data, sizeof(reply));
+            compact = put_time(&w, reply.master_time, NULL, &flags);
+            break;
+        }
+        case SCHEMA_START: {
+            start_data_t start;
+            memcpy(&start, cmd->data, sizeof(start));
+            compact = (start.valve_control & ~VALVE_MASK) == 0 && (start.valve_states & ~VALVE_MASK) == 0;
+            put_varint(&w, start.duration_sec);
+            put_byte(&w, (uint8_t)(start.valve_control | start.valve_states << 3));
+            break;
+        }
+        case SCHEMA_STATUS_RESPONSE: {
+            status_response_t status;
+            memcpy(&status, cmd->data, sizeof(status));
+            compact = put_time(&w, status.device_time, base, &flags) &&
+                      (status.valve_states & ~VALVE_MASK) == 0 && (status.pump_state & ~PUMP_MASK) == 0;
+            put_byte(&w, wire_quantize_soc(status.battery_soc));
+            put_byte(&w, (uint8_t)(status.valve_states | status.pump_state << 3));
+            break;
+        }
+        case SCHEMA_RAW:
+            compact = false;
+            break;
+    }
+
+    if (!compact || w.overflow || w.pos > sizeof(command_packet_t) + cmd->data_len) {
+        // Values the compact layout cannot hold, or not in fewer bytes,
+        // travel as v1 data
+        flags = WIRE_FLAG_RAW;
+        w.pos = V2_HEADER_LEN;
+        w.overflow = w.size < V2_HEADER_LEN;
+        for (size_t i = 0; i < cmd->data_len; i++) {
+            put_byte(&w, cmd->data[i]);
+        }
+    }
+    if (w.overflow) {
+        return 0;
+    }
+    out[0] = WIRE_MARKER | flags;
+    return w.pos;
+}
+
+typedef struct {
+    const uint8_t *data;
+    size_t len;
+    size_t pos;
+    bool short_read;
+} reader_t;
+
+static uint8_t get_byte(reader_t *r) {
+    if (r->pos >= r->len) {
+        r->short_read = true;
+        return 0;
+    }
+    return r->data[r->pos++];
+}
+
+static uint64_t get_varint(reader_t *r) {
+    uint64_t value = 0;
+    size_t n = r->short_read ? 0 : varint_decode(r->data + r->pos, r->len - r->pos, &value);
+    if (n == 0) {
+        r->short_read = true;
+    }
+    r->pos += n;
+    return value;
+}
+
+static esp_err_t get_time(reader_t *r, uint8_t flags, const wire_time_base_t *base, time_t *t) {
+    uint64_t max = sizeof(time_t) >= 8 ? INT64_MAX : INT32_MAX;
+    if (flags & WIRE_FLAG_DELTA_TIME) {
+        uint8_t tag = get_byte(r);
+        uint64_t delta = get_varint(r);
+        if (r->short_read) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        if (!base || !base->valid || tag != (uint8_t)base->time) {
+            return ESP_ERR_INVALID_STATE;
+        }
+        if (delta > max - (uint64_t)base->time) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        *t = base->time + (time_t)delta;
+        return ESP_OK;
+    }
+
+    uint64_t value = get_varint(r);
+    if (r->short_read || value > max) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *t = (time_t)value;
+    return ESP_OK;
+}
+
+esp_err_t wire_decode_v2(const uint8_t *data, size_t len, const wire_time_base_t *base,
+                         command_packet_t *out, size_t out_size, size_t *out_len) {
+    if (len < V2_HEADER_LEN || wire_frame_version(data, len) != WIRE_VERSION_V2 ||
+        (data[0] & ~(WIRE_MARKER_MASK | WIRE_VERSION_MASK) & ~WIRE_FLAGS_KNOWN) ||
+        out_size < sizeof(command_packet_t)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint8_t flags = data[0] & WIRE_FLAGS_KNOWN;
+    reader_t r = { .data = data, .len = len, .pos = V2_HEADER_LEN };
+    out->command = data[1];
+    schema_t schema = (flags & WIRE_FLAG_RAW) ? SCHEMA_RAW : schema_for_v2(data[1]);
+    if (schema != SCHEMA_STATUS_RESPONSE && (flags & WIRE_FLAG_DELTA_TIME)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    size_t data_len = 0;
+    esp_err_t err = ESP_OK;
+    switch (schema) {
+        case SCHEMA_SYNC: {
+            sync_data_t sync;
+            time_t t = 0;
+            err = get_time(&r, flags, base, &t);
+            sync.device_time = t;
+            sync.battery_soc = wire_dequantize_soc(get_byte(&r));
+            data_len = sizeof(sync);
+            if (err == ESP_OK && data_len <= out_size - sizeof(command_packet_t)) {
+                memcpy(out->data, &sync, sizeof(sync));
+            }
+            break;
+        }
+        case SCHEMA_SYNC_RESPONSE: {
+            sync_response_t reply;
+            time_t t = 0;
+            err = get_time(&r, flags, base, &t);
+            reply.master_time = t;
+            data_len = sizeof(reply);
+            if (err == ESP_OK && data_len <= out_size - sizeof(command_packet_t)) {
+                memcpy(out->data, &reply, sizeof(reply));
+            }
+            break;
+        }
+        case SCHEMA_START: {
+            start_data_t start;
+            uint64_t duration = get_varint(&r);
+            uint8_t valves = get_byte(&r);
+            if (duration > UINT32_MAX || (valves & 0xC0)) {
+                err = ESP_ERR_INVALID_ARG;
+            }
+            start.duration_sec = (uint32_t)duration;
+            start.valve_control = valves & VALVE_MASK;
+            start.valve_states = (valves >> 3) & VALVE_MASK;
+            data_len = sizeof(start);
+            if (err == ESP_OK && data_len <= out_size - sizeof(command_packet_t)) {
+                memcpy(out->data, &start, sizeof(start));
+            }
+            break;
+        }
+        case SCHEMA_STATUS_RESPONSE: {
+            status_response_t status;
+            time_t t = 0;
+            err = get_time(&r, flags, base, &t);
+            status.device_time = t;
+            status.battery_soc = wire_dequantize_soc(get_byte(&r));
+            uint8_t state = get_byte(&r);
+            if (state & 0xE0) {
+                err = err == ESP_OK ? ESP_ERR_INVALID_ARG : err;
+            }
+            status.valve_states = state & VALVE_MASK;
+            status.pump_state = (state >> 3) & PUMP_MASK;
+            data_len = sizeof(status);
+            if (err == ESP_OK && data_len <= out_size - sizeof(command_packet_t)) {
+                memcpy(out->data, &status, sizeof(status));
+            }
+            break;
+        }
+        case SCHEMA_RAW:
+            data_len = len - V2_HEADER_LEN;
+            if (data_len <= UINT8_MAX && data_len <= out_size - sizeof(command_packet_t)) {
+                memcpy(out->data, data + V2_HEADER_LEN, data_len);
+            }
+            r.pos = len;
+            break;
+    }
+
+    if (err != ESP_OK) {
+        return err;
+    }
+    // Compact layouts leave nothing over; a short or long frame is corrupt
+    if (r.short_read || r.pos != len || data_len > UINT8_MAX ||
+        data_len > out_size - sizeof(command_packet_t)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    out->data_len = (uint8_t)data_len;
+    *out_len = sizeof(command_packet_t) + data_len;
+    return ESP_OK;
+}
@@ -0,0 +1,47 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// 4 levels of 64 slots: covers 2^24 ticks (~194 days at one tick per second)
+#define TIMER_WHEEL_BITS   6
+#define TIMER_WHEEL_SLOTS  (1 << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_MASK   (TIMER_WHEEL_SLOTS - 1)
+#define TIMER_WHEEL_LEVELS 4
+#define TIMER_WHEEL_MAX_DELTA ((1UL << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS)) - 1)
+
+typedef struct timer_wheel_link {
+    struct timer_wheel_link *next;
+    struct timer_wheel_link *prev;
+} timer_wheel_link_t;
+
+typedef struct timer_wheel_timer timer_wheel_timer_t;
+typedef void (*timer_wheel_cb_t)(timer_wheel_timer_t *timer, void *arg);
+
+// Intrusive timer node; embed it in the owning structure
+struct timer_wheel_timer {
+    timer_wheel_link_t link; // Must stay first
+    uint32_t expires;
+    timer_wheel_cb_t callback;
+    void *arg;
+};
+
+typedef struct {
+    uint32_t now;            // Last processed tick
+    timer_wheel_link_t slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+} timer_wheel_t;
+
+void timer_wheel_init(timer_wheel_t *wheel, uint32_t now);
+void timer_wheel_timer_init(timer_wheel_timer_t *timer, timer_wheel_cb_t callback, void *arg);
+
+// Arm (or re-arm) a timer for an absolute tick. Expired ticks fire on the next advance.
+void timer_wheel_add(timer_wheel_t *wheel, timer_wheel_timer_t *timer, uint32_t expires);
+void timer_wheel_del(timer_wheel_timer_t *timer);
+bool timer_wheel_pending(const timer_wheel_timer_t *timer);
+
+// Process every tick up to and including 'now', firing expired timers.
+// Returns the number of callbacks invoked.
+int timer_wheel_advance(timer_wheel_t *wheel, uint32_t now);
+
+#endif // TIMER_WHEEL_H
@@ -0,0 +1,139 @@
+#include "timer_wheel.h"
+#include <stddef.h>
+
+static void list_init(timer_wheel_link_t *head) {
+    head->next = head;
+    head->prev = head;
+}
+
+static void list_append(timer_wheel_link_t *head, timer_wheel_link_t *link) {
+    link->prev = head->prev;
+    link->next = head;
+    head->prev->next = link;
+    head->prev = link;
+}
+
+static void list_unlink(timer_wheel_link_t *link) {
+    link->prev->next = link->next;
+    link->next->prev = link->prev;
+    link->next = NULL;
+    link->prev = NULL;
+}
+
+// Move every entry of 'from' onto the empty list 'to'
+static void list_splice(timer_wheel_link_t *from, timer_wheel_link_t *to) {
+    if (from->next == from) {
+        list_init(to);
+        return;
+    }
+    to->next = from->next;
+    to->prev = from->prev;
+    to->next->prev = to;
+    to->prev->next = to;
+    list_init(from);
+}
+
+// Place a timer relative to the current tick. Callers guarantee expires >= now.
+static void wheel_insert(timer_wheel_t *wheel, timer_wheel_timer_t *timer) {
+    uint32_t delta = timer->expires - wheel->now;
+    int level = 0;
+
+    while (level < TIMER_WHEEL_LEVELS - 1 &&
+           delta >= (1UL << (TIMER_WHEEL_BITS * (level + 1)))) {
+        level++;
+    }
+
+    uint32_t slot = (timer->expires >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK;
+    list_append(&wheel->slots[level][slot], &timer->link);
+}
+
+// Redistribute one slot of a higher level into the levels below it
+static void wheel_cascade(timer_wheel_t *wheel, int level) {
+    uint32_t slot = (wheel->now >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK;
+    timer_wheel_link_t pending;
+
+    list_splice(&wheel->slots[level][slot], &pending);
+    while (pending.next != &pending) {
+        timer_wheel_link_t *link = pending.next;
+        list_unlink(link);
+        wheel_insert(wheel, (timer_wheel_timer_t *)link);
+    }
+}
+
+void timer_wheel_init(timer_wheel_t *wheel, uint32_t now) {
+    wheel->now = now;
+    for (int level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+        for (int slot = 0; slot < TIMER_WHEEL_SLOTS; slot++) {
+            list_init(&wheel->slots[level][slot]);
+        }
+    }
+}
+
+void timer_wheel_timer_init(timer_wheel_timer_t *timer, timer_wheel_cb_t callback, void *arg) {
+    timer->link.next = NULL;
+    timer->link.prev = NULL;
+    timer->expires = 0;
+    timer->callback = callback;
+    timer->arg = arg;
+}
+
+void timer_wheel_add(timer_wheel_t *wheel, timer_wheel_timer_t *timer, uint32_t expires) {
+    if (timer_wheel_pending(timer)) {
+        list_unlink(&timer->link);
+    }
+
+    int32_t delta = (int32_t)(expires - wheel->now);
+    if (delta <= 0) {
+        expires = wheel->now + 1;
+    } else if ((uint32_t)delta > TIMER_WHEEL_MAX_DELTA) {
+        expires = wheel->now + TIMER_WHEEL_MAX_DELTA;
+    }
+
+    timer->expires = expires;
+    wheel_insert(wheel, timer);
+}
+
+void timer_wheel_del(timer_wheel_timer_t *timer) {
+    if (timer_wheel_pending(timer)) {
+        list_unlink(&timer->link);
+    }
+}
+
+bool timer_wheel_pending(const timer_wheel_timer_t *timer) {
+    return timer->link.next != NULL;
+}
+
+int timer_wheel_advance(timer_wheel_t *wheel, uint32_t now) {
+    int fired = 0;
+
+    while ((int32_t)(now - wheel->now) > 0) {
+        wheel->now++;
+
+        // Cascade each level whose lower-order digits just wrapped to zero
+        for (int level = 1; level < TIMER_WHEEL_LEVELS; level++) {
+            if (wheel->now & ((1UL << (TIMER_WHEEL_BITS * level)) - 1)) {
+                break;
+            }
+            wheel_cascade(wheel, level);
+        }
+
+        timer_wheel_link_t expired;
+        list_splice(&wheel->slots[0][wheel->now & TIMER_WHEEL_MASK], &expired);
+
+        // Callbacks may re-arm themselves or delete other timers on this list
+        while (expired.next != &expired) {
+            timer_wheel_timer_t *timer = (timer_wheel_timer_t *)expired.next;
+            list_unlink(&timer->link);
+            if ((int32_t)(timer->expires - wheel->now) > 0) {
+                wheel_insert(wheel, timer);
+                continue;
+            }
+            if (timer->callback) {
+                timer->callback(timer, timer->arg);
+            }
+            fired++;
+        }
+    }
+
+    return fired;
+}
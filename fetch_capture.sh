@@ -0,0 +1,33 @@
+#!/bin/bash
+
+# Download the bridge's ESP-NOW frame capture over MQTT.
+# Needs mosquitto-clients, jq and xxd.
+#
+# Usage: ./fetch_capture.sh <broker host> [topic prefix] [output file]
+
+HOST=${1:?usage: $0 <broker host> [topic prefix] [output file]}
+PREFIX=${2:-pump_controller}
+OUT=${3:-capture.bin}
+MQTT_ARGS=(-h "$HOST" ${MQTT_USERNAME:+-u "$MQTT_USERNAME"} ${MQTT_PASSWORD:+-P "$MQTT_PASSWORD"})
+
+: > "$OUT"
+offset=0
+while true; do
+    # Subscribe before asking so the reply cannot be missed
+    reply=$(mosquitto_sub "${MQTT_ARGS[@]}" -t "$PREFIX/bridge/capture" -C 1 -W 10 &
+            sleep 0.5
+            mosquitto_pub "${MQTT_ARGS[@]}" -t "$PREFIX/bridge/capture/read" -m "{\"offset\":$offset}"
+            wait)
+    if [ -z "$reply" ] || [ "$(echo "$reply" | jq -r '.data // empty' | wc -c)" -le 1 ]; then
+        break
+    fi
+
+    echo "$reply" | jq -r '.data' | xxd -r -p >> "$OUT"
+    size=$(echo "$reply" | jq -r '.size')
+    offset=$(stat -c %s "$OUT")
+    echo -ne "\r$offset / $size bytes"
+    [ "$offset" -ge "$size" ] && break
+done
+
+echo
+echo "Capture saved to $OUT; replay it with: build/host/sim_replay $OUT"
@@ -0,0 +1,95 @@
+#include "bench.h"
+#include <stddef.h>
+#include <stdio.h>
+#include <time.h>
+
+#define BENCH_TARGET_NS 200000000ULL  // ~200 ms per measurement
+
+volatile uintptr_t bench_sink;
+
+static uint64_t alloc_count;
+static uint64_t alloc_bytes;
+
+#ifdef BENCH_WRAP_MALLOC
+// Linked with -Wl,--wrap=malloc,... so every allocation made by code in this
+// binary (including cJSON) is counted
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size) {
+    alloc_count++;
+    alloc_bytes += size;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+    alloc_count++;
+    alloc_bytes += count * size;
+    return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+    alloc_count++;
+    alloc_bytes += size;
+    return __real_realloc(ptr, size);
+}
+
+bool bench_alloc_tracking(void) {
+    return true;
+}
+#else
+bool bench_alloc_tracking(void) {
+    return false;
+}
+#endif
+
+void bench_alloc_reset(void) {
+    alloc_count = 0;
+    alloc_bytes = 0;
+}
+
+bench_alloc_stats_t bench_alloc_get(void) {
+    bench_alloc_stats_t stats = { alloc_count, alloc_bytes };
+    return stats;
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static uint64_t time_iterations(bench_fn_t fn, void *ctx, uint64_t iterations) {
+    uint64_t start = now_ns();
+    for (uint64_t i = 0; i < iterations; i++) {
+        fn(ctx);
+    }
+    return now_ns() - start;
+}
+
+double bench_run(const char *name, bench_fn_t fn, void *ctx) {
+    // Grow the batch until it runs long enough to time reliably
+    uint64_t iterations = 1;
+    uint64_t elapsed = time_iterations(fn, ctx, iterations);
+    while (elapsed < BENCH_TARGET_NS / 10 && iterations < (1ULL << 40)) {
+        iterations *= 10;
+        elapsed = time_iterations(fn, ctx, iterations);
+    }
+    if (elapsed > 0 && elapsed < BENCH_TARGET_NS) {
+        iterations = iterations * BENCH_TARGET_NS / elapsed;
+    }
+
+    bench_alloc_reset();
+    elapsed = time_iterations(fn, ctx, iterations);
+    bench_alloc_stats_t allocs = bench_alloc_get();
+
+    double ns_per_op = (double)elapsed / iterations;
+    if (bench_alloc_tracking()) {
+        printf("%-32s %12.1f ns/op %10.2f allocs/op %10.1f B/op\n", name, ns_per_op,
+               (double)allocs.allocs / iterations, (double)allocs.bytes / iterations);
+    } else {
+        printf("%-32s %12.1f ns/op %10s allocs/op\n", name, ns_per_op, "n/a");
+    }
+    return ns_per_op;
+}
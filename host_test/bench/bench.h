@@ -0,0 +1,25 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef void (*bench_fn_t)(void *ctx);
+
+// Heap activity seen through the wrapped allocator
+typedef struct {
+    uint64_t allocs;
+    uint64_t bytes;
+} bench_alloc_stats_t;
+
+bool bench_alloc_tracking(void);
+void bench_alloc_reset(void);
+bench_alloc_stats_t bench_alloc_get(void);
+
+// Calibrate an iteration count, then print ns/op and allocations/op. Returns ns/op.
+double bench_run(const char *name, bench_fn_t fn, void *ctx);
+
+// Keep results observable so the optimizer cannot drop the work
+extern volatile uintptr_t bench_sink;
+
+#endif // BENCH_H
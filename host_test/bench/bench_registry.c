@@ -0,0 +1,142 @@
+// Device registry lookups against the linear scans it replaces, at several
+// fleet sizes. Built with DEVICE_MAX raised so 1,000 devices fit.
+#include "bench.h"
+#include "device_registry.h"
+#include "shared_commands.h"
+#include <stdio.h>
+#include <string.h>
+
+#define QUERY_COUNT 4096   // Power of two, cycled through by each benchmark
+
+typedef struct {
+    int devices;
+    device_registry_t registry;
+    uint8_t macs[DEVICE_MAX][6];
+    char mac_strs[DEVICE_MAX][MAC_STR_LEN];
+    uint8_t queries[QUERY_COUNT][6];
+    char query_strs[QUERY_COUNT][MAC_STR_LEN];
+    unsigned next;
+} registry_ctx_t;
+
+static registry_ctx_t ctx;
+static uint64_t rng_state = 0x9E3779B97F4A7C15ull;
+
+static uint32_t rng_next(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return (uint32_t)(rng_state >> 32);
+}
+
+// Realistic fleets share a handful of vendor prefixes
+static void random_mac(uint8_t mac[6]) {
+    static const uint8_t ouis[][3] = {{0x24, 0x6f, 0x28}, {0x30, 0xae, 0xa4}, {0x84, 0xcc, 0xa8}};
+    uint32_t r = rng_next();
+    memcpy(mac, ouis[r % 3], 3);
+    r = rng_next();
+    mac[3] = (uint8_t)(r >> 16);
+    mac[4] = (uint8_t)(r >> 8);
+    mac[5] = (uint8_t)r;
+}
+
+static void setup(int devices, bool hits) {
+    ctx.devices = devices;
+    ctx.next = 0;
+    device_registry_init(&ctx.registry);
+    for (int i = 0; i < devices; i++) {
+        do {
+            random_mac(ctx.macs[i]);
+        } while (device_registry_find(&ctx.registry, ctx.macs[i]) != DEVICE_INDEX_NONE);
+        device_registry_add(&ctx.registry, ctx.macs[i]);
+        mac_bytes_to_str(ctx.macs[i], ctx.mac_strs[i]);
+    }
+
+    for (int q = 0; q < QUERY_COUNT; q++) {
+        if (hits) {
+            memcpy(ctx.queries[q], ctx.macs[rng_next() % devices], 6);
+        } else {
+            do {
+                random_mac(ctx.queries[q]);
+            } while (device_registry_find(&ctx.registry, ctx.queries[q]) != DEVICE_INDEX_NONE);
+        }
+        mac_bytes_to_str(ctx.queries[q], ctx.query_strs[q]);
+    }
+}
+
+static void bench_registry_find(void *arg) {
+    (void)arg;
+    bench_sink += device_registry_find(&ctx.registry, ctx.queries[ctx.next++ & (QUERY_COUNT - 1)]);
+}
+
+static void bench_registry_find_str(void *arg) {
+    (void)arg;
+    bench_sink += device_registry_find_str(&ctx.registry, ctx.query_strs[ctx.next++ & (QUERY_COUNT - 1)]);
+}
+
+// What fleet_table and link_table did: memcmp over a device array
+static void bench_memcmp_scan(void *arg) {
+    (void)arg;
+    const uint8_t *mac = ctx.queries[ctx.next++ & (QUERY_COUNT - 1)];
+    int found = -1;
+    for (int i = 0; i < ctx.devices; i++) {
+        if (memcmp(ctx.macs[i], mac, 6) == 0) {
+            found = i;
+            break;
+        }
+    }
+    bench_sink += found;
+}
+
+// Keying state on the MAC strings taken from topics
+static void bench_strcmp_scan(void *arg) {
+    (void)arg;
+    const char *mac_str = ctx.query_strs[ctx.next++ & (QUERY_COUNT - 1)];
+    int found = -1;
+    for (int i = 0; i < ctx.devices; i++) {
+        if (strcmp(ctx.mac_strs[i], mac_str) == 0) {
+            found = i;
+            break;
+        }
+    }
+    bench_sink += found;
+}
+
+int main(void) {
+    static const int sizes[] = {10, 100, 1000};
+    static const struct {
+        const char *name;
+        bench_fn_t fn;
+    } variants[] = {
+        {"registry_find", bench_registry_find},
+        {"registry_find_str", bench_registry_find_str},
+        {"memcmp_scan", bench_memcmp_scan},
+        {"strcmp_scan", bench_strcmp_scan},
+    };
+    enum { VARIANTS = sizeof(variants) / sizeof(variants[0]) };
+    double mops[2][3][VARIANTS];
+
+    printf("%-32s %15s %20s\n", "benchmark", "time", "heap");
+    for (int hits = 1; hits >= 0; hits--) {
+        for (int s = 0; s < 3; s++) {
+            setup(sizes[s], hits);
+            for (int v = 0; v < VARIANTS; v++) {
+                char name[48];
+                snprintf(name, sizeof(name), "%s/%d/%s", variants[v].name, sizes[s], hits ? "hit" : "miss");
+                mops[hits][s][v] = 1000.0 / bench_run(name, variants[v].fn, NULL);
+            }
+        }
+    }
+
+    printf("\nlookups/sec (millions)   %8s %8s %8s | %8s %8s %8s\n",
+           "hit/10", "hit/100", "hit/1000", "miss/10", "miss/100", "miss/1000");
+    for (int v = 0; v < VARIANTS; v++) {
+        printf("%-24s", variants[v].name);
+        for (int hits = 1; hits >= 0; hits--) {
+            for (int s = 0; s < 3; s++) {
+                printf(" %8.1f", mops[hits][s][v]);
+            }
+            printf(hits ? " |" : "\n");
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,46 @@
+// Command payload parsing from run_command
+#include "command_json.h"
+#include <stdint.h>
+#include <stdlib.h>
+
+#define START_FIELDS (COMMAND_FIELD_REQUEST_ID | COMMAND_FIELD_DURATION | \
+                      COMMAND_FIELD_VALVE_CONTROL | COMMAND_FIELD_VALVE_STATES)
+#define SYNC_FIELDS  (COMMAND_FIELD_REQUEST_ID | COMMAND_FIELD_DEVICE_TIME | COMMAND_FIELD_BATTERY_SOC)
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    static const command_type_t commands[] = {CMD_START, CMD_SYNC, CMD_STOP};
+
+    for (size_t i = 0; i < sizeof(commands) / sizeof(commands[0]); i++) {
+        command_json_t parsed;
+        if (command_json_parse(commands[i], (const char *)data, size, &parsed) != ESP_OK) {
+            continue;
+        }
+
+        // An empty payload means a bare command; anything else accepted
+        // carries exactly the data its command needs
+        if (parsed.fields == 0 && parsed.data_len == 0 && commands[i] != CMD_STOP) {
+            continue;
+        }
+        switch (commands[i]) {
+            case CMD_START:
+                if ((parsed.fields & ~START_FIELDS) || !(parsed.fields & COMMAND_FIELD_DURATION) ||
+                    parsed.data_len != sizeof(start_data_t)) {
+                    abort();
+                }
+                break;
+            case CMD_SYNC:
+                if ((parsed.fields & ~SYNC_FIELDS) || !(parsed.fields & COMMAND_FIELD_DEVICE_TIME) ||
+                    parsed.data_len != sizeof(sync_data_t) ||
+                    !(parsed.data.sync.battery_soc >= 0.0f && parsed.data.sync.battery_soc <= 100.0f)) {
+                    abort();
+                }
+                break;
+            default:
+                if ((parsed.fields & ~COMMAND_FIELD_REQUEST_ID) || parsed.data_len != 0) {
+                    abort();
+                }
+                break;
+        }
+    }
+    return 0;
+}
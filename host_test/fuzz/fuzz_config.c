@@ -0,0 +1,23 @@
+// config_manager_init, minus the file read
+#include "config_manager.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ASSERT_TERMINATED(field) \
+    do { if (strnlen((field), sizeof(field)) >= sizeof(field)) abort(); } while (0)
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    if (!config_manager_parse((const char *)data, size)) {
+        return 0;
+    }
+
+    const app_config_t *cfg = config_manager_get();
+    ASSERT_TERMINATED(cfg->mqtt_uri);
+    ASSERT_TERMINATED(cfg->mqtt_username);
+    ASSERT_TERMINATED(cfg->mqtt_password);
+    ASSERT_TERMINATED(cfg->topic_prefix);
+    ASSERT_TERMINATED(cfg->wifi_ssid);
+    ASSERT_TERMINATED(cfg->wifi_password);
+    return 0;
+}
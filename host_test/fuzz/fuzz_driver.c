@@ -0,0 +1,153 @@
+// Standalone driver for toolchains without libFuzzer.
+//
+//   fuzz_<target> [--random N] <file-or-dir>...
+//
+// Replays every corpus file through LLVMFuzzerTestOneInput. With --random,
+// additionally runs N inputs made by mutating randomly chosen corpus files.
+#include <dirent.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#define MAX_INPUT_SIZE 4096
+#define MAX_SEEDS      256
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+typedef struct {
+    uint8_t *data;
+    size_t size;
+} seed_t;
+
+static seed_t seeds[MAX_SEEDS];
+static int seed_count = 0;
+
+static void run_file(const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "Cannot open %s\n", path);
+        exit(1);
+    }
+
+    uint8_t *data = malloc(MAX_INPUT_SIZE);
+    size_t size = fread(data, 1, MAX_INPUT_SIZE, f);
+    fclose(f);
+
+    // Exact-size copy so sanitizers catch reads past the input
+    uint8_t *input = malloc(size ? size : 1);
+    memcpy(input, data, size);
+    free(data);
+    LLVMFuzzerTestOneInput(input, size);
+
+    if (seed_count < MAX_SEEDS) {
+        seeds[seed_count].data = input;
+        seeds[seed_count].size = size;
+        seed_count++;
+    } else {
+        free(input);
+    }
+}
+
+static void run_path(const char *path) {
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        fprintf(stderr, "Cannot stat %s\n", path);
+        exit(1);
+    }
+    if (!S_ISDIR(st.st_mode)) {
+        run_file(path);
+        return;
+    }
+
+    DIR *dir = opendir(path);
+    struct dirent *entry;
+    while (dir && (entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+        char child[1024];
+        snprintf(child, sizeof(child), "%s/%s", path, entry->d_name);
+        run_path(child);
+    }
+    if (dir) {
+        closedir(dir);
+    }
+}
+
+static uint32_t rng_state = 0x9e3779b9;
+
+static uint32_t next_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static size_t mutate(uint8_t *buf, size_t size) {
+    int rounds = 1 + next_random() % 4;
+    for (int i = 0; i < rounds; i++) {
+        size_t pos = size ? next_random() % size : 0;
+        switch (next_random() % 5) {
+            case 0: // Flip a bit
+                if (size) buf[pos] ^= 1u << (next_random() % 8);
+                break;
+            case 1: // Random byte
+                if (size) buf[pos] = (uint8_t)next_random();
+                break;
+            case 2: // Interesting byte
+                if (size) {
+                    static const uint8_t interesting[] = {0x00, 0x01, 0x7f, 0x80, 0xff, '/', ':', '"'};
+                    buf[pos] = interesting[next_random() % sizeof(interesting)];
+                }
+                break;
+            case 3: // Insert
+                if (size < MAX_INPUT_SIZE) {
+                    memmove(buf + pos + 1, buf + pos, size - pos);
+                    buf[pos] = (uint8_t)next_random();
+                    size++;
+                }
+                break;
+            default: // Truncate
+                size = pos;
+                break;
+        }
+    }
+    return size;
+}
+
+int main(int argc, char **argv) {
+    long random_runs = 0;
+    int files = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--random") == 0 && i + 1 < argc) {
+            random_runs = strtol(argv[++i], NULL, 10);
+            continue;
+        }
+        run_path(argv[i]);
+        files++;
+    }
+    printf("Replayed corpus from %d path(s), %d seed(s)\n", files, seed_count);
+
+    static uint8_t buf[MAX_INPUT_SIZE];
+    for (long run = 0; run < random_runs; run++) {
+        size_t size = 0;
+        if (seed_count > 0) {
+            const seed_t *seed = &seeds[next_random() % seed_count];
+            memcpy(buf, seed->data, seed->size);
+            size = seed->size;
+        }
+        size = mutate(buf, size);
+
+        uint8_t *input = malloc(size ? size : 1);
+        memcpy(input, buf, size);
+        LLVMFuzzerTestOneInput(input, size);
+        free(input);
+    }
+    if (random_runs > 0) {
+        printf("Ran %ld mutated input(s)\n", random_runs);
+    }
+    return 0;
+}
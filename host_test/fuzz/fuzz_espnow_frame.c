@@ -0,0 +1,22 @@
+// espnow_recv_cb length validation
+#include "shared_commands.h"
+#include <stddef.h>
+#include <stdint.h>
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    if (size > 0x7fffffff) {
+        return 0;
+    }
+    if (!command_packet_validate(data, (int)size)) {
+        return 0;
+    }
+
+    // Accepted frames must be readable up to data_len
+    const command_packet_t *cmd = (const command_packet_t *)data;
+    volatile uint8_t sum = 0;
+    for (int i = 0; i < cmd->data_len; i++) {
+        sum += cmd->data[i];
+    }
+    (void)sum;
+    return 0;
+}
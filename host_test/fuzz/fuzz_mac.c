@@ -0,0 +1,25 @@
+// MAC parsing used by handle_mqtt_command
+#include "shared_commands.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    char *str = malloc(size + 1);
+    memcpy(str, data, size);
+    str[size] = '\0';
+
+    uint8_t mac[6];
+    if (mac_str_to_bytes(str, mac)) {
+        // Anything accepted must survive a round trip
+        char back[MAC_STR_LEN];
+        mac_bytes_to_str(mac, back);
+        if (strcasecmp(back, str) != 0) {
+            abort();
+        }
+    }
+
+    free(str);
+    return 0;
+}
@@ -0,0 +1,24 @@
+// Command topic parsing from mqtt_event_handler
+#include "mqtt_topic.h"
+#include "shared_commands.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    if (size > 0x7fffffff) {
+        return 0;
+    }
+
+    char mac_str[MAC_STR_LEN];
+    char command[32];
+    if (!mqtt_parse_command_topic((const char *)data, (int)size, "pump_controller",
+                                  mac_str, sizeof(mac_str), command, sizeof(command))) {
+        return 0;
+    }
+
+    if (strlen(mac_str) >= sizeof(mac_str) || strlen(command) >= sizeof(command)) {
+        abort();
+    }
+    return 0;
+}
@@ -0,0 +1,19 @@
+// str_to_command on the command segment of a topic
+#include "shared_commands.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    char *str = malloc(size + 1);
+    memcpy(str, data, size);
+    str[size] = '\0';
+
+    command_type_t cmd = str_to_command(str);
+    if (cmd != CMD_INVALID && strcmp(command_to_str(cmd), str) != 0) {
+        abort();
+    }
+
+    free(str);
+    return 0;
+}
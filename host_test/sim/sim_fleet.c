@@ -0,0 +1,265 @@
+// Multi-bridge fleet simulation: several bridges, each with its own
+// fleet_table_t, exchange RSSI summaries through an in-memory broker while
+// simulated devices send frames. Checks that every frame is forwarded by
+// exactly one bridge, that ownership follows moving devices and survives a
+// bridge going offline, and that forwarded commands reach the owner.
+#include "fleet_table.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#define SIM_BRIDGES          4
+#define SIM_DEVICES          48
+#define SIM_TICK_MS          100
+#define SIM_FRAME_PERIOD_MS  1000
+#define SIM_SUMMARY_MS       5000
+#define SIM_TTL_MS           (3 * SIM_SUMMARY_MS)
+#define SIM_HYSTERESIS_DB    4
+#define SIM_SENSITIVITY_DBM  (-92)
+#define SIM_NOISE_DB         3.0
+
+typedef struct {
+    double x, y;
+    bool online;
+    char id[FLEET_BRIDGE_ID_LEN];
+    device_registry_t registry;   // Each bridge's shared device registry
+    fleet_table_t table;
+} sim_bridge_t;
+
+typedef struct {
+    double x, y;
+    uint8_t mac[6];
+    uint32_t next_frame_ms;
+} sim_device_t;
+
+typedef struct {
+    uint32_t frames;          // Frames heard by at least one bridge
+    uint32_t forwarded;
+    uint32_t duplicates;      // Frames forwarded by more than one bridge
+    uint32_t dropped;         // Frames heard but forwarded by nobody
+    uint32_t commands;
+    uint32_t commands_misrouted;
+} sim_stats_t;
+
+static sim_bridge_t bridges[SIM_BRIDGES];
+static sim_device_t devices[SIM_DEVICES];
+static uint64_t rng_state = 0x9E3779B97F4A7C15ull;
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { printf("FAIL: " __VA_ARGS__); printf("\n"); failures++; } \
+} while (0)
+
+static uint32_t rng_next(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return (uint32_t)(rng_state >> 32);
+}
+
+static double rng_uniform(void) {
+    return (rng_next() + 0.5) / 4294967296.0;
+}
+
+static double rng_gauss(void) {
+    return sqrt(-2.0 * log(rng_uniform())) * cos(6.283185307179586 * rng_uniform());
+}
+
+// Log-distance path loss, 1 m reference at -40 dBm, exponent 2.7
+static double mean_rssi(const sim_bridge_t *bridge, const sim_device_t *device) {
+    double dx = bridge->x - device->x;
+    double dy = bridge->y - device->y;
+    double dist = sqrt(dx * dx + dy * dy);
+    return -40.0 - 27.0 * log10(dist < 1.0 ? 1.0 : dist);
+}
+
+// The broker: every online bridge receives every summary, including its own
+static void exchange_summaries(uint32_t now_ms) {
+    fleet_summary_entry_t entries[FLEET_MAX_DEVICES];
+    for (int b = 0; b < SIM_BRIDGES; b++) {
+        if (!bridges[b].online) {
+            continue;
+        }
+        int count = fleet_table_local_summary(&bridges[b].table, now_ms, entries, FLEET_MAX_DEVICES);
+        for (int r = 0; r < SIM_BRIDGES; r++) {
+            if (!bridges[r].online) {
+                continue;
+            }
+            for (int i = 0; i < count; i++) {
+                device_ref_t ref = device_registry_acquire(&bridges[r].registry, entries[i].mac);
+                fleet_table_apply_report(&bridges[r].table, bridges[b].id, ref,
+                                         entries[i].mac, entries[i].rssi, now_ms);
+            }
+        }
+    }
+}
+
+static void send_frame(sim_device_t *device, uint32_t now_ms, sim_stats_t *stats) {
+    int heard = 0;
+    int forwarders = 0;
+    for (int b = 0; b < SIM_BRIDGES; b++) {
+        if (!bridges[b].online) {
+            continue;
+        }
+        double rssi = mean_rssi(&bridges[b], device) + SIM_NOISE_DB * rng_gauss();
+        if (rssi < SIM_SENSITIVITY_DBM) {
+            continue;
+        }
+        heard++;
+        device_ref_t ref = device_registry_acquire(&bridges[b].registry, device->mac);
+        fleet_table_observe(&bridges[b].table, ref, device->mac, (int8_t)lround(rssi), now_ms);
+        if (fleet_table_is_local(&bridges[b].table, ref, now_ms)) {
+            forwarders++;
+        }
+    }
+
+    if (heard == 0) {
+        return;
+    }
+    stats->frames++;
+    stats->forwarded += forwarders > 0;
+    stats->duplicates += forwarders > 1;
+    stats->dropped += forwarders == 0;
+}
+
+// A shared subscription hands the command to an arbitrary bridge, which
+// forwards it if another bridge owns the device
+static void send_command(sim_device_t *device, uint32_t now_ms, sim_stats_t *stats) {
+    int receiver;
+    do {
+        receiver = rng_next() % SIM_BRIDGES;
+    } while (!bridges[receiver].online);
+
+    device_ref_t ref = device_registry_ref(&bridges[receiver].registry, device->mac);
+    const char *owner = fleet_table_owner(&bridges[receiver].table, ref, now_ms);
+    int executor = receiver;
+    if (owner) {
+        for (int b = 0; b < SIM_BRIDGES; b++) {
+            if (strcmp(bridges[b].id, owner) == 0) {
+                executor = b;
+            }
+        }
+    }
+
+    // The executor should hold the strongest link (within the hysteresis margin)
+    double best = -1000.0;
+    for (int b = 0; b < SIM_BRIDGES; b++) {
+        if (bridges[b].online && mean_rssi(&bridges[b], device) > best) {
+            best = mean_rssi(&bridges[b], device);
+        }
+    }
+    stats->commands++;
+    if (!bridges[executor].online ||
+        mean_rssi(&bridges[executor], device) < best - SIM_HYSTERESIS_DB - 2 * SIM_NOISE_DB) {
+        stats->commands_misrouted++;
+    }
+}
+
+static void run(uint32_t start_ms, uint32_t end_ms, sim_stats_t *stats) {
+    for (uint32_t now = start_ms; now < end_ms; now += SIM_TICK_MS) {
+        for (int d = 0; d < SIM_DEVICES; d++) {
+            if (now >= devices[d].next_frame_ms) {
+                send_frame(&devices[d], now, stats);
+                devices[d].next_frame_ms = now + SIM_FRAME_PERIOD_MS;
+            }
+        }
+        if (now % SIM_SUMMARY_MS == 0) {
+            exchange_summaries(now);
+        }
+        if (now % 1000 == 0) {
+            send_command(&devices[rng_next() % SIM_DEVICES], now, stats);
+        }
+    }
+}
+
+static int owner_index(int observer, const sim_device_t *device, uint32_t now_ms) {
+    device_ref_t ref = device_registry_ref(&bridges[observer].registry, device->mac);
+    const char *owner = fleet_table_owner(&bridges[observer].table, ref, now_ms);
+    for (int b = 0; owner && b < SIM_BRIDGES; b++) {
+        if (strcmp(bridges[b].id, owner) == 0) {
+            return b;
+        }
+    }
+    return -1;
+}
+
+static void print_stats(const char *phase, const sim_stats_t *stats) {
+    printf("%-14s frames %6u  forwarded %6u  duplicates %4u (%.2f%%)  dropped %4u (%.2f%%)  "
+           "commands %4u misrouted %u\n",
+           phase, stats->frames, stats->forwarded,
+           stats->duplicates, 100.0 * stats->duplicates / (stats->frames ? stats->frames : 1),
+           stats->dropped, 100.0 * stats->dropped / (stats->frames ? stats->frames : 1),
+           stats->commands, stats->commands_misrouted);
+}
+
+int main(void) {
+    // Four bridges on a 40 m x 40 m site, devices scattered between them
+    static const double positions[SIM_BRIDGES][2] = {{0, 0}, {40, 0}, {0, 40}, {40, 40}};
+    for (int b = 0; b < SIM_BRIDGES; b++) {
+        bridges[b].x = positions[b][0];
+        bridges[b].y = positions[b][1];
+        bridges[b].online = true;
+        snprintf(bridges[b].id, sizeof(bridges[b].id), "bridge-%d", b);
+        device_registry_init(&bridges[b].registry);
+        fleet_table_init(&bridges[b].table, bridges[b].id, SIM_TTL_MS, SIM_HYSTERESIS_DB);
+    }
+    for (int d = 0; d < SIM_DEVICES; d++) {
+        devices[d].x = rng_uniform() * 40.0;
+        devices[d].y = rng_uniform() * 40.0;
+        uint8_t mac[6] = {0x24, 0x6f, 0x28, 0x00, 0x00, (uint8_t)d};
+        memcpy(devices[d].mac, mac, 6);
+        devices[d].next_frame_ms = rng_next() % SIM_FRAME_PERIOD_MS;
+    }
+
+    // Warm-up: until the first summaries arrive each bridge believes it owns everything
+    sim_stats_t warmup = {0};
+    run(0, 2 * SIM_SUMMARY_MS, &warmup);
+    print_stats("warm-up", &warmup);
+
+    sim_stats_t steady = {0};
+    run(2 * SIM_SUMMARY_MS, 120000, &steady);
+    print_stats("steady", &steady);
+    CHECK(steady.dropped + steady.duplicates <= steady.frames / 50,
+          "steady state: %u duplicates + %u drops of %u frames",
+          steady.duplicates, steady.dropped, steady.frames);
+    CHECK(steady.commands_misrouted == 0, "steady state: %u commands misrouted",
+          steady.commands_misrouted);
+
+    // All bridges must agree on every owner
+    uint32_t now = 120000;
+    for (int d = 0; d < SIM_DEVICES; d++) {
+        int owner = owner_index(0, &devices[d], now);
+        for (int b = 1; b < SIM_BRIDGES; b++) {
+            CHECK(owner_index(b, &devices[d], now) == owner,
+                  "device %d: bridge %d disagrees on owner", d, b);
+        }
+    }
+
+    // Carry device 0 into the corner of bridge 3
+    devices[0].x = 39.0;
+    devices[0].y = 39.0;
+    sim_stats_t moving = {0};
+    run(120000, 120000 + 4 * SIM_SUMMARY_MS, &moving);
+    print_stats("after move", &moving);
+    now = 120000 + 4 * SIM_SUMMARY_MS;
+    CHECK(owner_index(3, &devices[0], now) == 3, "moved device not taken over by bridge 3");
+
+    // Take bridge 0 offline; its devices must fail over once its reports expire
+    bridges[0].online = false;
+    sim_stats_t failover = {0};
+    run(now, now + SIM_TTL_MS + 2 * SIM_SUMMARY_MS, &failover);
+    print_stats("failover", &failover);
+    now += SIM_TTL_MS + 2 * SIM_SUMMARY_MS;
+
+    sim_stats_t recovered = {0};
+    run(now, now + 60000, &recovered);
+    print_stats("recovered", &recovered);
+    CHECK(recovered.dropped + recovered.duplicates <= recovered.frames / 50,
+          "after failover: %u duplicates + %u drops of %u frames",
+          recovered.duplicates, recovered.dropped, recovered.frames);
+    CHECK(recovered.commands_misrouted == 0, "after failover: %u commands misrouted",
+          recovered.commands_misrouted);
+
+    printf("%s\n", failures ? "FAILED" : "OK");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,137 @@
+// Adaptive PHY rate simulation: peers at different link budgets exchange
+// status frames and commands with the bridge, once at the fixed 1 Mbps
+// default and once with the link table choosing rates. Reports channel
+// utilization and delivery for both and checks that adaptation saves
+// airtime without costing delivery or flapping between rates.
+#include "link_table.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#define SIM_FRAMES        2000   // Commands sent to each peer
+#define SIM_PAYLOAD       12     // command_packet_t + start_data_t
+#define SIM_NOISE_DB      2.5
+
+typedef struct {
+    const char *name;
+    double mean_rssi;
+} sim_peer_t;
+
+typedef struct {
+    uint32_t sent;
+    uint32_t delivered;
+    uint32_t rate_changes;
+    link_rate_t final_rate;
+} sim_result_t;
+
+// Sensitivities matching link_table.c
+static const int sensitivity[LINK_RATE_COUNT] = {-98, -95, -92, -88, -87, -83, -75};
+
+static const sim_peer_t peers[] = {
+    {"close",    -45.0},
+    {"room",     -62.0},
+    {"garden",   -74.0},
+    {"far",      -84.0},
+    {"edge",     -91.0},
+};
+#define SIM_PEERS (int)(sizeof(peers) / sizeof(peers[0]))
+
+static uint64_t rng_state = 0x2545F4914F6CDD1Dull;
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { printf("FAIL: " __VA_ARGS__); printf("\n"); failures++; } \
+} while (0)
+
+static double rng_uniform(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return ((rng_state >> 11) + 0.5) / 9007199254740992.0;
+}
+
+static double rng_gauss(void) {
+    return sqrt(-2.0 * log(rng_uniform())) * cos(6.283185307179586 * rng_uniform());
+}
+
+// Frame delivery (including the MAC's own retries) falls off around the sensitivity
+static bool delivered(double rssi, link_rate_t rate) {
+    double p = 1.0 / (1.0 + exp(-(rssi - sensitivity[rate] - 2.0) / 1.5));
+    return rng_uniform() < p;
+}
+
+static sim_result_t run_peer(link_table_t *table, const sim_peer_t *sim, int index, bool adaptive) {
+    sim_result_t result = {0};
+    uint8_t mac[6] = {0x24, 0x6f, 0x28, 0x00, 0x01, (uint8_t)index};
+    // Each simulated peer is its own registered device
+    device_ref_t device = { .index = index, .generation = 1 };
+    link_peer_t *peer = link_table_get(table, device, mac, true);
+    link_rate_t last_rate = peer->rate;
+
+    for (int i = 0; i < SIM_FRAMES; i++) {
+        // The device reports status between commands
+        double rssi = sim->mean_rssi + SIM_NOISE_DB * rng_gauss();
+        if (adaptive && rssi >= sensitivity[LINK_RATE_1M]) {
+            link_table_on_rx(peer, (int8_t)lround(rssi));
+        }
+        if (!adaptive) {
+            peer->rate = LINK_RATE_1M;
+        }
+
+        link_table_on_tx(table, peer, SIM_PAYLOAD);
+        bool ok = delivered(sim->mean_rssi + SIM_NOISE_DB * rng_gauss(), peer->rate);
+        link_table_on_tx_done(peer, ok);
+        result.sent++;
+        result.delivered += ok;
+
+        if (!adaptive) {
+            peer->rate = LINK_RATE_1M;
+        }
+        if (peer->rate != last_rate) {
+            result.rate_changes++;
+            last_rate = peer->rate;
+        }
+    }
+    result.final_rate = peer->rate;
+    return result;
+}
+
+int main(void) {
+    link_table_t fixed;
+    link_table_t adaptive;
+    link_table_init(&fixed);
+    link_table_init(&adaptive);
+
+    printf("%-8s %6s | %8s %10s | %8s %10s %6s %8s\n", "peer", "rssi",
+           "1M del%", "airtime", "adp del%", "airtime", "rate", "changes");
+
+    uint32_t fixed_delivered = 0;
+    uint32_t adaptive_delivered = 0;
+    for (int p = 0; p < SIM_PEERS; p++) {
+        uint64_t fixed_before = fixed.airtime_us;
+        uint64_t adaptive_before = adaptive.airtime_us;
+        sim_result_t base = run_peer(&fixed, &peers[p], p, false);
+        sim_result_t adapt = run_peer(&adaptive, &peers[p], p, true);
+        fixed_delivered += base.delivered;
+        adaptive_delivered += adapt.delivered;
+
+        printf("%-8s %6.0f | %7.1f%% %8.1fms | %7.1f%% %8.1fms %6s %8u\n",
+               peers[p].name, peers[p].mean_rssi,
+               100.0 * base.delivered / base.sent, (fixed.airtime_us - fixed_before) / 1000.0,
+               100.0 * adapt.delivered / adapt.sent, (adaptive.airtime_us - adaptive_before) / 1000.0,
+               link_rate_name(adapt.final_rate), adapt.rate_changes);
+
+        // Losing a frame costs more than the airtime saved on it
+        CHECK(adapt.delivered + adapt.sent / 100 >= base.delivered,
+              "%s: adaptive delivered %u vs %u at 1M", peers[p].name, adapt.delivered, base.delivered);
+        CHECK(adapt.rate_changes <= 20, "%s: rate flapped %u times", peers[p].name, adapt.rate_changes);
+    }
+
+    printf("total airtime: 1M %.1f ms, adaptive %.1f ms (%.1f%%); delivered %u vs %u\n",
+           fixed.airtime_us / 1000.0, adaptive.airtime_us / 1000.0,
+           100.0 * adaptive.airtime_us / fixed.airtime_us, fixed_delivered, adaptive_delivered);
+    CHECK(adaptive.airtime_us * 2 < fixed.airtime_us, "adaptive rates saved less than half the airtime");
+
+    printf("%s\n", failures ? "FAILED" : "OK");
+    return failures ? 1 : 0;
+}
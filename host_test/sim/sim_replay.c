@@ -0,0 +1,589 @@
+// Capture replay: feeds an ESP-NOW frame capture (frame_capture.h) through a
+// simulated radio channel and the bridge's receive/send path at increasing
+// speed-ups, and reports where throughput saturates and how latency degrades.
+//
+//   sim_replay [capture.bin] [--rx-us N] [--tx-us N] [--queue N] [--wire-v2]
+//
+// Without a capture file a synthetic fleet capture is generated, written
+// through the capture encoder and decoded again, so the log format is
+// exercised as well (this is what ctest runs). --wire-v2 re-encodes v1
+// frames in the compact format of wire_format.h, as if every device spoke
+// it; the synthetic run replays both and compares them.
+//
+// Model: one shared channel serves frames in order, each occupying its
+// airtime at the sender's rate plus contention overhead; frames that find
+// SIM_CHANNEL_BACKLOG frames already waiting are lost to collisions. The
+// bridge is a single FIFO server with a bounded queue (the Wi-Fi task's
+// receive queue and the MQTT command queue): received frames cost rx_us of
+// bridge time after they leave the air, sent frames cost tx_us before they
+// go on air. Latency runs from the captured time to the end of both stages.
+#include "frame_capture.h"
+#include "link_table.h"
+#include "device_registry.h"
+#include "shared_commands.h"
+#include "wire_format.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SIM_RX_SERVICE_US     1500   // Status frame: validate, format and publish to MQTT
+#define SIM_TX_SERVICE_US     800    // Command: parse payload and hand to ESP-NOW
+#define SIM_QUEUE_DEPTH       32
+#define SIM_CHANNEL_BACKLOG   16
+#define SIM_CONTENTION_US     100    // DIFS plus mean backoff per frame
+#define SIM_DROP_LIMIT_PCT    1.0    // Saturated once more than this is lost
+#define SIM_LATENCY_LIMIT     5.0    // Latency knee: p99 this many times the 1x value
+
+// Synthetic capture
+#define SYN_DEVICES           48
+#define SYN_DURATION_S        600
+#define SYN_STATUS_PERIOD_S   10
+#define SYN_SYNC_PERIOD_S     60
+#define SYN_COMMANDS          120
+
+static const double speeds[] = {1, 2, 5, 10, 20, 50, 100, 200, 500, 1000};
+#define SPEED_COUNT (int)(sizeof(speeds) / sizeof(speeds[0]))
+
+typedef struct {
+    uint64_t time_us;
+    capture_dir_t direction;
+    uint8_t mac[6];
+    int8_t rssi;
+    uint8_t len;
+    uint8_t payload[FRAME_CAPTURE_MAX_PAYLOAD];
+} frame_t;
+
+typedef struct {
+    double speed;
+    uint32_t offered;
+    uint32_t delivered;
+    uint32_t dropped_queue;
+    uint32_t dropped_air;
+    uint32_t malformed;
+    double duration_s;
+    double channel_busy_pct;
+    double p50_ms;
+    double p99_ms;
+    double max_ms;
+} replay_result_t;
+
+typedef struct {
+    uint32_t rx_us;
+    uint32_t tx_us;
+    int queue_depth;
+    bool wire_v2;
+} sim_config_t;
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { printf("FAIL: " __VA_ARGS__); printf("\n"); failures++; } \
+} while (0)
+
+// ---------------------------------------------------------------------------
+// Capture loading and synthesis
+// ---------------------------------------------------------------------------
+
+static int decode_capture(const uint8_t *data, size_t len, frame_t **out) {
+    if (!frame_capture_check_header(data, len)) {
+        return -1;
+    }
+
+    int capacity = 1024;
+    int count = 0;
+    frame_t *frames = malloc(capacity * sizeof(frame_t));
+    uint64_t last_us = 0;
+    size_t pos = FRAME_CAPTURE_HEADER_LEN;
+    while (pos < len) {
+        capture_record_t record;
+        int n = frame_capture_decode(data + pos, len - pos, &last_us, &record);
+        if (n <= 0) {
+            if (n < 0) {
+                printf("corrupt record at offset %zu, replaying what came before\n", pos);
+            }
+            break;
+        }
+        pos += n;
+
+        if (count == capacity) {
+            capacity *= 2;
+            frames = realloc(frames, capacity * sizeof(frame_t));
+        }
+        frame_t *frame = &frames[count++];
+        frame->time_us = record.timestamp_us;
+        frame->direction = record.direction;
+        memcpy(frame->mac, record.mac, 6);
+        frame->rssi = record.rssi;
+        frame->len = record.len;
+        memcpy(frame->payload, record.payload, record.len);
+    }
+    *out = frames;
+    return count;
+}
+
+static uint64_t rng_state = 0x2545F4914F6CDD1Dull;
+
+static double rng_uniform(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return ((rng_state >> 11) + 0.5) / 9007199254740992.0;
+}
+
+static int compare_time(const void *a, const void *b) {
+    const frame_t *fa = a;
+    const frame_t *fb = b;
+    return fa->time_us < fb->time_us ? -1 : fa->time_us > fb->time_us;
+}
+
+static void add_frame(frame_t *frame, uint64_t time_us, capture_dir_t direction, const uint8_t mac[6],
+                      int8_t rssi, uint8_t command, const void *data, uint8_t data_len) {
+    frame->time_us = time_us;
+    frame->direction = direction;
+    memcpy(frame->mac, mac, 6);
+    frame->rssi = direction == CAPTURE_RX ? rssi : 0;
+    command_packet_t *packet = (command_packet_t *)frame->payload;
+    packet->command = command;
+    packet->data_len = data_len;
+    memcpy(packet->data, data, data_len);
+    frame->len = sizeof(command_packet_t) + data_len;
+}
+
+// Pumps reporting status with jitter, periodic syncs answered by the bridge,
+// and bursts of commands from the backend, in capture file form
+static size_t synthesize_capture(uint8_t **out) {
+    // Status periods jitter down to 0.9x, so allow twice the nominal count
+    int per_device = 2 * (SYN_DURATION_S / SYN_STATUS_PERIOD_S) + 2 * (SYN_DURATION_S / SYN_SYNC_PERIOD_S + 1);
+    int max_frames = SYN_DEVICES * per_device + 2 * SYN_COMMANDS;
+    frame_t *frames = malloc(max_frames * sizeof(frame_t));
+    int count = 0;
+
+    for (int d = 0; d < SYN_DEVICES; d++) {
+        uint8_t mac[6] = {0x24, 0x6f, 0x28, 0x10, 0x00, (uint8_t)d};
+        int8_t rssi = (int8_t)(-45 - (int)(rng_uniform() * 45));
+        double phase = rng_uniform() * SYN_STATUS_PERIOD_S;
+
+        for (double t = phase; t < SYN_DURATION_S; t += SYN_STATUS_PERIOD_S * (0.9 + 0.2 * rng_uniform())) {
+            status_response_t status = {
+                .device_time = 1760000000 + (time_t)t,
+                .battery_soc = 80.0f,
+                .pump_state = PUMP_INACTIVE,
+                .valve_states = 0
+            };
+            add_frame(&frames[count++], (uint64_t)(t * 1e6), CAPTURE_RX, mac, rssi,
+                      CMD_STATUS | CMD_RESPONSE, &status, sizeof(status));
+        }
+        for (double t = phase + 1.0; t < SYN_DURATION_S; t += SYN_SYNC_PERIOD_S) {
+            sync_data_t sync = { .device_time = 1760000000 + (time_t)t, .battery_soc = 80.0f };
+            sync_response_t reply = { .master_time = 1760000000 + (time_t)t };
+            add_frame(&frames[count++], (uint64_t)(t * 1e6), CAPTURE_RX, mac, rssi, CMD_SYNC, &sync, sizeof(sync));
+            add_frame(&frames[count++], (uint64_t)(t * 1e6) + 2000, CAPTURE_TX, mac, rssi,
+                      CMD_SYNC | CMD_RESPONSE, &reply, sizeof(reply));
+        }
+    }
+
+    // Commands come in bursts, e.g. a schedule starting every zone at once
+    for (int c = 0; c < SYN_COMMANDS; c++) {
+        uint8_t mac[6] = {0x24, 0x6f, 0x28, 0x10, 0x00, (uint8_t)(c % SYN_DEVICES)};
+        double t = (c / SYN_DEVICES) * (SYN_DURATION_S / 3.0) + 30.0 + (c % SYN_DEVICES) * 0.02;
+        start_data_t start = { .duration_sec = 900, .valve_control = 3, .valve_states = 1 };
+        uint8_t ack = 0;
+        add_frame(&frames[count++], (uint64_t)(t * 1e6), CAPTURE_TX, mac, 0, CMD_START, &start, sizeof(start));
+        add_frame(&frames[count++], (uint64_t)(t * 1e6) + 30000, CAPTURE_RX, mac, -60,
+                  CMD_START | CMD_RESPONSE, &ack, 0);
+    }
+    qsort(frames, count, sizeof(frame_t), compare_time);
+
+    size_t capacity = FRAME_CAPTURE_HEADER_LEN + (size_t)count * FRAME_CAPTURE_MAX_RECORD;
+    uint8_t *log = malloc(capacity);
+    frame_capture_write_header(log);
+    size_t len = FRAME_CAPTURE_HEADER_LEN;
+    uint64_t last_us = 0;
+    for (int i = 0; i < count; i++) {
+        capture_record_t record = {
+            .timestamp_us = frames[i].time_us,
+            .direction = frames[i].direction,
+            .rssi = frames[i].rssi,
+            .len = frames[i].len,
+            .payload = frames[i].payload
+        };
+        memcpy(record.mac, frames[i].mac, 6);
+        size_t n = frame_capture_encode(&record, &last_us, log + len, capacity - len);
+        CHECK(n > 0, "record %d did not encode", i);
+        len += n;
+    }
+    free(frames);
+    *out = log;
+    return len;
+}
+
+// Re-encode v1 frames as v2, tracking each device's time base from the
+// SYNCs the bridge sent it. Returns the payload bytes saved.
+static long convert_to_wire_v2(frame_t *frames, int count) {
+    static device_registry_t registry;
+    static wire_time_base_t bases[DEVICE_MAX];
+    device_registry_init(&registry);
+    memset(bases, 0, sizeof(bases));
+
+    long saved = 0;
+    for (int i = 0; i < count; i++) {
+        frame_t *frame = &frames[i];
+        if (wire_frame_version(frame->payload, frame->len) != WIRE_VERSION_V1 ||
+            !command_packet_validate(frame->payload, frame->len)) {
+            continue;
+        }
+        int index = device_registry_add(&registry, frame->mac);
+        wire_time_base_t none = {0};
+        wire_time_base_t *base = index != DEVICE_INDEX_NONE ? &bases[index] : &none;
+
+        const command_packet_t *cmd = (const command_packet_t *)frame->payload;
+        uint8_t encoded[WIRE_MAX_FRAME];
+        size_t len = wire_encode_v2(cmd, base, encoded, sizeof(encoded));
+        if (len == 0) {
+            continue;
+        }
+
+        // Sent time settings become the base (the replay assumes delivery);
+        // the time leads both sync_data_t and sync_response_t
+        if (frame->direction == CAPTURE_TX && (cmd->command & ~CMD_RESPONSE) == CMD_SYNC &&
+            cmd->data_len >= sizeof(time_t)) {
+            base->valid = true;
+            memcpy(&base->time, cmd->data, sizeof(time_t));
+        }
+        saved += frame->len - (long)len;
+        memcpy(frame->payload, encoded, len);
+        frame->len = (uint8_t)len;
+    }
+    return saved;
+}
+
+// What the bridge's receive path accepts; v2 frames timed against a base
+// the replay does not know count as valid
+static bool frame_valid(const frame_t *frame) {
+    if (wire_frame_version(frame->payload, frame->len) != WIRE_VERSION_V2) {
+        return command_packet_validate(frame->payload, frame->len);
+    }
+    uint8_t decoded[sizeof(command_packet_t) + UINT8_MAX];
+    size_t decoded_len;
+    esp_err_t err = wire_decode_v2(frame->payload, frame->len, NULL, (command_packet_t *)decoded,
+                                   sizeof(decoded), &decoded_len);
+    return err == ESP_OK || err == ESP_ERR_INVALID_STATE;
+}
+
+// ---------------------------------------------------------------------------
+// Discrete-event replay
+// ---------------------------------------------------------------------------
+
+typedef enum {
+    STAGE_AIR,
+    STAGE_BRIDGE
+} stage_t;
+
+// Completion times of the work waiting at or in service by one FIFO stage;
+// enough to know how deep its queue is when the next frame arrives
+typedef struct {
+    double *done;
+    int capacity;
+    int head;
+    int count;
+    double free_at;
+    double busy_us;
+} fifo_t;
+
+static void fifo_init(fifo_t *fifo, int capacity) {
+    memset(fifo, 0, sizeof(*fifo));
+    fifo->done = malloc(capacity * sizeof(double));
+    fifo->capacity = capacity;
+}
+
+// Offer work arriving at 'at' needing 'service_us'. Returns its completion
+// time, or a negative value if 'limit' items are already waiting.
+static double fifo_offer(fifo_t *fifo, double at, double service_us, int limit) {
+    while (fifo->count > 0 && fifo->done[fifo->head] <= at) {
+        fifo->head = (fifo->head + 1) % fifo->capacity;
+        fifo->count--;
+    }
+    if (fifo->count >= limit) {
+        return -1.0;
+    }
+
+    double start = at > fifo->free_at ? at : fifo->free_at;
+    fifo->free_at = start + service_us;
+    fifo->busy_us += service_us;
+    fifo->done[(fifo->head + fifo->count) % fifo->capacity] = fifo->free_at;
+    fifo->count++;
+    return fifo->free_at;
+}
+
+static int compare_double(const void *a, const void *b) {
+    double da = *(const double *)a;
+    double db = *(const double *)b;
+    return da < db ? -1 : da > db;
+}
+
+static double percentile(const double *sorted, int count, double pct) {
+    if (count == 0) {
+        return 0.0;
+    }
+    int index = (int)ceil(pct / 100.0 * count) - 1;
+    return sorted[index < 0 ? 0 : index];
+}
+
+// Stages are visited in capture order. Received frames reach the bridge in
+// the order they left the air, which with one FIFO channel is capture order;
+// sent frames enter the bridge at their captured time. Both are close enough
+// to arrival order for FIFO bookkeeping at the queue depths modelled here.
+static replay_result_t replay(const frame_t *frames, int count, double speed, const sim_config_t *config) {
+    replay_result_t result = { .speed = speed };
+    static link_table_t links;
+    static device_registry_t registry;
+    link_table_init(&links);
+    device_registry_init(&registry);
+
+    fifo_t air;
+    fifo_t bridge;
+    fifo_init(&air, SIM_CHANNEL_BACKLOG + 1);
+    fifo_init(&bridge, config->queue_depth + 1);
+    double *latencies = malloc((count > 0 ? count : 1) * sizeof(double));
+    double first_us = count ? frames[0].time_us / speed : 0;
+    double last_done = first_us;
+
+    for (int i = 0; i < count; i++) {
+        const frame_t *frame = &frames[i];
+        double at = frame->time_us / speed;
+        double done;
+        result.offered++;
+
+        if (frame->direction == CAPTURE_RX) {
+            // Devices send at the default rate
+            double airtime = link_rate_airtime_us(LINK_RATE_1M, frame->len) + SIM_CONTENTION_US;
+            double heard = fifo_offer(&air, at, airtime, SIM_CHANNEL_BACKLOG);
+            if (heard < 0) {
+                result.dropped_air++;
+                continue;
+            }
+            done = fifo_offer(&bridge, heard, config->rx_us, config->queue_depth);
+            if (done < 0) {
+                result.dropped_queue++;
+                continue;
+            }
+
+            // The bridge's own per-frame bookkeeping
+            if (!frame_valid(frame)) {
+                result.malformed++;
+            }
+            device_ref_t device = device_registry_acquire(&registry, frame->mac);
+            link_peer_t *peer = link_table_get(&links, device, frame->mac, true);
+            if (peer && frame->rssi != 0) {
+                link_table_on_rx(peer, frame->rssi);
+            }
+        } else {
+            double handed = fifo_offer(&bridge, at, config->tx_us, config->queue_depth);
+            if (handed < 0) {
+                result.dropped_queue++;
+                continue;
+            }
+            device_ref_t device = device_registry_acquire(&registry, frame->mac);
+            link_peer_t *peer = link_table_get(&links, device, frame->mac, true);
+            link_table_on_tx(&links, peer, frame->len);
+            double airtime = link_rate_airtime_us(peer->rate, frame->len) + SIM_CONTENTION_US;
+            done = fifo_offer(&air, handed, airtime, SIM_CHANNEL_BACKLOG);
+            if (done < 0) {
+                result.dropped_air++;
+                continue;
+            }
+            link_table_on_tx_done(peer, true);
+        }
+
+        latencies[result.delivered++] = (done - at) / 1000.0;
+        if (done > last_done) {
+            last_done = done;
+        }
+    }
+
+    qsort(latencies, result.delivered, sizeof(double), compare_double);
+    result.duration_s = (last_done - first_us) / 1e6;
+    result.channel_busy_pct = last_done > first_us ? 100.0 * air.busy_us / (last_done - first_us) : 0.0;
+    result.p50_ms = percentile(latencies, result.delivered, 50);
+    result.p99_ms = percentile(latencies, result.delivered, 99);
+    result.max_ms = result.delivered ? latencies[result.delivered - 1] : 0.0;
+
+    free(latencies);
+    free(air.done);
+    free(bridge.done);
+    return result;
+}
+
+static double drop_pct(const replay_result_t *r) {
+    return r->offered ? 100.0 * (r->dropped_queue + r->dropped_air) / r->offered : 0.0;
+}
+
+// ---------------------------------------------------------------------------
+
+static uint8_t *read_file(const char *path, size_t *len) {
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    uint8_t *data = malloc(size > 0 ? size : 1);
+    *len = fread(data, 1, size, file);
+    fclose(file);
+    return data;
+}
+
+// Replay at every speed, print the table, and find the latency knee and
+// the saturation point (indices into speeds, -1 if never reached)
+static void sweep(const frame_t *frames, int count, double span_s, const sim_config_t *config,
+                  replay_result_t *results, int *saturated, int *knee) {
+    printf("%7s %10s %10s %8s %8s %9s %9s %9s\n",
+           "speed", "offered/s", "done/s", "drop%", "air%", "p50 ms", "p99 ms", "max ms");
+    *saturated = -1;
+    *knee = -1;
+    for (int s = 0; s < SPEED_COUNT; s++) {
+        replay_result_t *r = &results[s];
+        *r = replay(frames, count, speeds[s], config);
+        double offered_rate = span_s > 0 ? r->offered / (span_s / speeds[s]) : 0.0;
+        double done_rate = r->duration_s > 0 ? r->delivered / r->duration_s : 0.0;
+        printf("%6.0fx %10.1f %10.1f %7.2f%% %7.1f%% %9.2f %9.2f %9.2f\n", speeds[s], offered_rate,
+               done_rate, drop_pct(r), r->channel_busy_pct, r->p50_ms, r->p99_ms, r->max_ms);
+
+        if (*saturated < 0 && drop_pct(r) > SIM_DROP_LIMIT_PCT) {
+            *saturated = s;
+        }
+        if (*knee < 0 && s > 0 && r->p99_ms > SIM_LATENCY_LIMIT * results[0].p99_ms) {
+            *knee = s;
+        }
+    }
+
+    printf("\n");
+    if (*knee < 0) {
+        printf("latency: p99 within %.0fx of the 1x value up to %.0fx\n", SIM_LATENCY_LIMIT, speeds[SPEED_COUNT - 1]);
+    } else {
+        printf("latency: p99 %.1f ms at %.0fx against %.1f ms at 1x (bursts start queueing)\n",
+               results[*knee].p99_ms, speeds[*knee], results[0].p99_ms);
+    }
+    if (*saturated < 0) {
+        printf("throughput: no saturation up to %.0fx\n", speeds[SPEED_COUNT - 1]);
+    } else {
+        const replay_result_t *r = &results[*saturated];
+        printf("throughput: saturates at %.0fx, %.0f frames/s offered, %.2f%% lost (%u queue, %u air)\n",
+               speeds[*saturated], span_s > 0 ? count / (span_s / speeds[*saturated]) : 0.0,
+               drop_pct(r), r->dropped_queue, r->dropped_air);
+    }
+
+}
+
+int main(int argc, char **argv) {
+    sim_config_t config = {
+        .rx_us = SIM_RX_SERVICE_US,
+        .tx_us = SIM_TX_SERVICE_US,
+        .queue_depth = SIM_QUEUE_DEPTH
+    };
+    const char *path = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--rx-us") == 0 && i + 1 < argc) {
+            config.rx_us = (uint32_t)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--tx-us") == 0 && i + 1 < argc) {
+            config.tx_us = (uint32_t)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--queue") == 0 && i + 1 < argc) {
+            config.queue_depth = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--wire-v2") == 0) {
+            config.wire_v2 = true;
+        } else if (argv[i][0] != '-' && !path) {
+            path = argv[i];
+        } else {
+            printf("usage: %s [capture.bin] [--rx-us N] [--tx-us N] [--queue N] [--wire-v2]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (config.queue_depth < 1) {
+        config.queue_depth = 1;
+    }
+
+    uint8_t *log;
+    size_t log_len;
+    if (path) {
+        log = read_file(path, &log_len);
+        if (!log) {
+            printf("cannot read %s\n", path);
+            return 2;
+        }
+    } else {
+        log_len = synthesize_capture(&log);
+    }
+
+    frame_t *frames = NULL;
+    int count = decode_capture(log, log_len, &frames);
+    if (count < 0) {
+        printf("%s is not a frame capture (version %d)\n", path ? path : "synthetic log", FRAME_CAPTURE_VERSION);
+        free(log);
+        return 2;
+    }
+
+    if (config.wire_v2) {
+        printf("re-encoded as wire v2: %ld payload bytes saved\n", convert_to_wire_v2(frames, count));
+    }
+
+    uint32_t rx = 0;
+    for (int i = 0; i < count; i++) {
+        rx += frames[i].direction == CAPTURE_RX;
+    }
+    double span_s = count > 1 ? (frames[count - 1].time_us - frames[0].time_us) / 1e6 : 0.0;
+    printf("%s: %d frames (%u received, %u sent) over %.1f s, %zu bytes (%.1f B/frame)\n",
+           path ? path : "synthetic capture", count, rx, count - rx, span_s, log_len,
+           count ? (double)(log_len - FRAME_CAPTURE_HEADER_LEN) / count : 0.0);
+    printf("bridge %u us/rx, %u us/tx, queue %d\n\n", config.rx_us, config.tx_us, config.queue_depth);
+
+    replay_result_t results[SPEED_COUNT];
+    int saturated = -1;
+    int knee = -1;
+    sweep(frames, count, span_s, &config, results, &saturated, &knee);
+
+    if (!path) {
+        // Synthetic traffic must round-trip the log format and fit at field speed
+        CHECK(results[0].malformed == 0, "%u malformed frames after decoding", results[0].malformed);
+        CHECK(drop_pct(&results[0]) == 0.0, "frames dropped at 1x");
+        CHECK(saturated > 0, "synthetic load never saturated the bridge");
+        CHECK(knee < 0 || saturated < 0 || knee <= saturated, "latency degraded only after frames were lost");
+        for (int s = 1; s < SPEED_COUNT; s++) {
+            CHECK(results[s].p99_ms + 0.01 >= results[s - 1].p99_ms || drop_pct(&results[s]) > 0,
+                  "p99 latency fell from %.0fx to %.0fx without drops", speeds[s - 1], speeds[s]);
+        }
+
+        if (!config.wire_v2) {
+            // The same traffic with every device on the compact format
+            frame_t *compact = malloc((count > 0 ? count : 1) * sizeof(frame_t));
+            memcpy(compact, frames, count * sizeof(frame_t));
+            long v1_bytes = 0;
+            for (int i = 0; i < count; i++) {
+                v1_bytes += frames[i].len;
+            }
+            long saved = convert_to_wire_v2(compact, count);
+            printf("\nwire v2: %.1f B/frame against %.1f in v1 (%.0f%% less payload)\n",
+                   count ? (double)(v1_bytes - saved) / count : 0.0, count ? (double)v1_bytes / count : 0.0,
+                   v1_bytes ? 100.0 * saved / v1_bytes : 0.0);
+
+            replay_result_t v2_results[SPEED_COUNT];
+            int v2_saturated;
+            int v2_knee;
+            sweep(compact, count, span_s, &config, v2_results, &v2_saturated, &v2_knee);
+            printf("channel busy at 1x: %.2f%% in v2 against %.2f%% in v1\n",
+                   v2_results[0].channel_busy_pct, results[0].channel_busy_pct);
+
+            CHECK(v2_results[0].malformed == 0, "%u malformed v2 frames", v2_results[0].malformed);
+            CHECK(saved > 0 && v2_results[0].channel_busy_pct < results[0].channel_busy_pct,
+                  "wire v2 did not reduce airtime");
+            CHECK(v2_saturated < 0 || v2_saturated >= saturated, "wire v2 saturated at a lower speed");
+            free(compact);
+        }
+        printf("%s\n", failures ? "FAILED" : "OK");
+    }
+
+    free(frames);
+    free(log);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,18 @@
+// Host build stand-in for the ESP-IDF header of the same name.
+// Logging compiles away so fuzzing and benchmarks measure only the parsers,
+// but format strings are still type-checked.
+#ifndef ESP_LOG_H
+#define ESP_LOG_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define ESP_LOG_HOST(tag, format, ...) do { if (0) printf(format, ##__VA_ARGS__); } while (0)
+
+#define ESP_LOGE(tag, format, ...) ESP_LOG_HOST(tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) ESP_LOG_HOST(tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) ESP_LOG_HOST(tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) ESP_LOG_HOST(tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...) ESP_LOG_HOST(tag, format, ##__VA_ARGS__)
+
+#endif // ESP_LOG_H
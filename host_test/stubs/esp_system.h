@@ -0,0 +1,8 @@
+// Host build stand-in for the ESP-IDF header of the same name
+#ifndef ESP_SYSTEM_H
+#define ESP_SYSTEM_H
+
+#include "esp_err.h"
+#include <stdlib.h>
+
+#endif // ESP_SYSTEM_H
@@ -9,12 +9,22 @@
 #include "esp_event.h"
 #include "esp_netif.h"
 #include "shared_commands.h"
+#include "command_json.h"
 #include "espnow_handler.h"
 #include "custom_mqtt_client.h"
 #include "config_manager.h"
+#include "scheduler.h"
+#include "rpc_tracker.h"
+#include "mem_profiler.h"
+#include "fleet.h"
+#include "esp_timer.h"
+#include "esp_spiffs.h"
+#include "esp_netif_sntp.h"
 #include "cJSON.h"
 #include <inttypes.h>
+#include <stdio.h>
 #include <string.h>
+#include <sys/stat.h>
 
 // WiFi credentials - replace with your own
 #define WIFI_SSID "Tokamabahe!"
@@ -25,6 +35,25 @@
 #define MQTT_USERNAME "mqtt2"
 #define MQTT_PASSWORD "mqttilman"
 #define MQTT_TOPIC_PREFIX "pump_controller"
+#define MQTT_USE_V5 true
+
+// Local schedule engine
+#define SNTP_SERVER "pool.ntp.org"
+#define TIMEZONE "CET-1CEST,M3.5.0,M10.5.0/3"
+#define STORAGE_BASE_PATH "/spiffs"
+#define SCHEDULES_PATH STORAGE_BASE_PATH "/schedules.json"
+
+// Multi-bridge fleet mode: devices are owned by the bridge with the best link
+#define FLEET_MODE false
+#define FLEET_SHARED_GROUP "bridges"
+
+// Memory budget report period (0 = on request only)
+#define MEM_PROFILE_INTERVAL_MS 60000
+
+// ESP-NOW frame capture for replay on the host (host_test/sim/sim_replay.c)
+#define CAPTURE_PATH STORAGE_BASE_PATH "/capture.bin"
+#define CAPTURE_MAX_BYTES (256 * 1024)
+#define CAPTURE_READ_CHUNK 384  // Hex-encoded, so a chunk fits the default MQTT buffer
 
 #define TAG "MQTT_ESPNOW_BRIDGE"
 
@@ -62,17 +91,15 @@ static void event_handler(void* arg, esp_event_base_t event_base,
     }
 }
 
-static void handle_espnow_message(const uint8_t *mac_addr, const command_packet_t *cmd) {
-    char mac_str[18] = {0};
+static void handle_espnow_message(const uint8_t *mac_addr, const command_packet_t *cmd, int8_t rssi) {
+    char mac_str[MAC_STR_LEN] = {0};
     
     // Check for NULL MAC address
     if (mac_addr == NULL) {
         ESP_LOGE(TAG, "Received NULL MAC address in ESPNOW message");
         strcpy(mac_str, "unknown");
     } else {
-        snprintf(mac_str, sizeof(mac_str), "%02x:%02x:%02x:%02x:%02x:%02x",
-                mac_addr[0], mac_addr[1], mac_addr[2],
-                mac_addr[3], mac_addr[4], mac_addr[5]);
+        mac_bytes_to_str(mac_addr, mac_str);
     }
     
     // Check for NULL command
@@ -84,6 +111,20 @@ static void handle_espnow_message(const uint8_t *mac_addr, const command_packet_
     // Now it's safe to access cmd->command since we've checked cmd is not NULL
     ESP_LOGI(TAG, "Received ESPNOW message from %s: %s", 
             mac_str, command_to_str(cmd->command));
+    
+    // Close out the MQTT command this frame answers, if any
+    if (mac_addr != NULL && (cmd->command & CMD_RESPONSE)) {
+        rpc_tracker_match_response(mac_addr, cmd->command, cmd->data, cmd->data_len);
+    }
+    
+    // In fleet mode only the owning bridge republishes the device's frames
+    if (mac_addr != NULL) {
+        fleet_observe(mac_addr, rssi);
+        if (!fleet_is_local(mac_addr)) {
+            ESP_LOGD(TAG, "Frame from %s left to its owner", mac_str);
+            return;
+        }
+    }
             
     // Convert to JSON and publish to MQTT
     cJSON *root = cJSON_CreateObject();
@@ -111,92 +152,426 @@ static void handle_espnow_message(const uint8_t *mac_addr, const command_packet_
     mqtt_publish_status(mac_str, command_to_str(cmd->command), json);
     
     cJSON_Delete(root);
-    free(json);
+    cJSON_free(json);
+}
+
+// MQTT 5 request/response: tell the caller whether the command went out over ESP-NOW
+static void reply_to_command(const mqtt_response_ctx_t* response, const char* mac_str,
+                             const char* command, esp_err_t err) {
+    if (response == NULL) {
+        return;
+    }
+
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "mac", mac_str);
+    cJSON_AddStringToObject(root, "command", command);
+    cJSON_AddStringToObject(root, "result", err == ESP_OK ? "sent" : "error");
+    if (err != ESP_OK) {
+        cJSON_AddStringToObject(root, "error", esp_err_to_name(err));
+    }
+
+    char *json = cJSON_PrintUnformatted(root);
+    if (json) {
+        mqtt_publish_response(response, json);
+        cJSON_free(json);
+    }
+    cJSON_Delete(root);
+}
+
+static const char* rpc_outcome_to_str(rpc_outcome_t outcome) {
+    switch (outcome) {
+        case RPC_OUTCOME_OK: return "ok";
+        case RPC_OUTCOME_TIMEOUT: return "timeout";
+        case RPC_OUTCOME_SEND_FAILED: return "send_failed";
+        case RPC_OUTCOME_BUSY: return "busy";
+        default: return "unknown";
+    }
+}
+
+static void handle_rpc_result(const rpc_result_t *result) {
+    char mac_str[MAC_STR_LEN];
+    mac_bytes_to_str(result->mac, mac_str);
+
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddNumberToObject(root, "request_id", result->request_id);
+    cJSON_AddStringToObject(root, "command", command_to_str(result->command));
+    cJSON_AddStringToObject(root, "outcome", rpc_outcome_to_str(result->outcome));
+    cJSON_AddNumberToObject(root, "latency_ms", result->latency_us / 1000.0);
+    if (result->outcome == RPC_OUTCOME_OK) {
+        cJSON_AddNumberToObject(root, "response_len", result->response_len);
+    }
+
+    char *json = cJSON_PrintUnformatted(root);
+    if (json) {
+        mqtt_publish_result(mac_str, json);
+        // MQTT 5 callers also get the final result on their response topic
+        if (result->user_ctx) {
+            mqtt_publish_response(result->user_ctx, json);
+        }
+        cJSON_free(json);
+    }
+    cJSON_Delete(root);
+    free(result->user_ctx);
 }
 
-static void handle_mqtt_command(const char* mac_str, const char* command, const char* payload) {
+// Send a command and track it until the device answers or the request times out
+static void send_tracked(const uint8_t mac[6], const char* mac_str, const char* command,
+                         const command_packet_t *cmd, uint32_t request_id, int64_t received_us,
+                         const mqtt_response_ctx_t* response) {
+    mqtt_response_ctx_t *response_copy = NULL;
+    if (response) {
+        response_copy = malloc(sizeof(*response_copy));
+        if (response_copy) {
+            *response_copy = *response;
+        }
+    }
+
+    // Register before sending so a fast response cannot overtake the entry
+    rpc_handle_t handle;
+    esp_err_t err = rpc_tracker_begin(mac, request_id, cmd->command, received_us,
+                                      RPC_DEFAULT_TIMEOUT_MS, response_copy, &handle);
+    if (err == ESP_ERR_INVALID_STATE) {
+        // Its response could not be told apart from the pending one's
+        rpc_result_t busy = {
+            .request_id = request_id,
+            .command = cmd->command,
+            .outcome = RPC_OUTCOME_BUSY,
+            .latency_us = esp_timer_get_time() - received_us,
+            .user_ctx = response_copy
+        };
+        memcpy(busy.mac, mac, sizeof(busy.mac));
+        handle_rpc_result(&busy);
+        return;
+    }
+    if (err != ESP_OK) {
+        free(response_copy);
+        reply_to_command(response, mac_str, command, espnow_send(mac, cmd));
+        return;
+    }
+
+    if (espnow_send_tracked(mac, cmd, handle) != ESP_OK) {
+        rpc_tracker_fail(handle);
+    }
+}
+
+// Runs in the Wi-Fi task; the tracker reports the failure from its own task
+static void handle_send_result(const uint8_t *mac_addr, uint32_t token, bool delivered) {
+    if (!delivered) {
+        rpc_tracker_fail(token);
+    }
+}
+
+static void run_command(const char* mac_str, const char* command, const char* payload,
+                        const mqtt_response_ctx_t* response) {
+    int64_t received_us = esp_timer_get_time();
     ESP_LOGI(TAG, "Received MQTT command: %s for %s", command, mac_str);
     
     // Parse MAC address
     uint8_t mac[6]; // MAC address is 6 bytes
-    sscanf(mac_str, "%hhx:%hhx:%hhx:%hhx:%hhx:%hhx", 
-           &mac[0], &mac[1], &mac[2], &mac[3], &mac[4], &mac[5]);
+    if (!mac_str_to_bytes(mac_str, mac)) {
+        ESP_LOGE(TAG, "Invalid MAC address: %s", mac_str);
+        reply_to_command(response, mac_str, command, ESP_ERR_INVALID_ARG);
+        return;
+    }
     
     // Parse command
     command_type_t cmd_type = str_to_command(command);
-    if (cmd_type == 0) {  // Assuming 0 is an invalid command
+    if (cmd_type == CMD_INVALID) {
         ESP_LOGE(TAG, "Unknown command: %s", command);
+        reply_to_command(response, mac_str, command, ESP_ERR_NOT_SUPPORTED);
         return;
     }
     
-    // Create command packet
-    // Allocate memory for the command packet with extra space for data
-    uint8_t data_size = 0;
-    cJSON *root = cJSON_Parse(payload);
-    
-    // Determine data size based on command type
-    if (root) {
-        // Calculate data size based on command type and payload
-        // This is a simplified example - adjust based on your actual data structures
-        switch(cmd_type) {
-            case CMD_START:
-                data_size = sizeof(start_data_t);
-                break;
-            case CMD_SYNC:
-                data_size = sizeof(sync_data_t);
-                break;
-            default:
-                data_size = 0;
-                break;
-        }
-        
-        // Allocate memory for command packet with data
-        command_packet_t *cmd = malloc(sizeof(command_packet_t) + data_size);
-        if (cmd == NULL) {
-            ESP_LOGE(TAG, "Failed to allocate memory for command packet");
-            cJSON_Delete(root);
-            return;
+    // One pass over the payload, straight into the ESP-NOW data without a JSON tree
+    command_json_t parsed;
+    esp_err_t err = command_json_parse(cmd_type, payload, payload ? strlen(payload) : 0, &parsed);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Rejected %s payload for %s: %s", command, mac_str, esp_err_to_name(err));
+        reply_to_command(response, mac_str, command, err);
+        return;
+    }
+    
+    // Callers may supply their own id to correlate results
+    uint32_t request_id = (parsed.fields & COMMAND_FIELD_REQUEST_ID) ?
+                          parsed.request_id : rpc_tracker_next_id();
+    
+    command_packet_t *cmd = mem_profiler_malloc(MEM_SITE_COMMAND_PACKET,
+                                                sizeof(command_packet_t) + parsed.data_len);
+    if (cmd == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate memory for command packet");
+        reply_to_command(response, mac_str, command, ESP_ERR_NO_MEM);
+        return;
+    }
+    
+    cmd->command = cmd_type;
+    cmd->data_len = parsed.data_len;
+    memcpy(cmd->data, &parsed.data, parsed.data_len);
+    
+    // Send via ESP-NOW
+    send_tracked(mac, mac_str, command, cmd, request_id, received_us, response);
+    mem_profiler_free(MEM_SITE_COMMAND_PACKET, cmd);
+}
+
+static void handle_mqtt_command(const char* mac_str, const char* command, const char* payload,
+                                const mqtt_response_ctx_t* response) {
+    // In fleet mode a command may reach any bridge; pass it on to the device's owner
+    uint8_t mac[6];
+    if (mac_str_to_bytes(mac_str, mac) &&
+        fleet_forward_command(mac, mac_str, command, payload, response)) {
+        return;
+    }
+    run_command(mac_str, command, payload, response);
+}
+
+// Every bridge holds the same schedules; only the owner sends to each device
+static esp_err_t send_scheduled(const uint8_t *mac_addr, const command_packet_t *cmd) {
+    if (!fleet_is_local(mac_addr)) {
+        return ESP_OK;
+    }
+    return espnow_send(mac_addr, cmd);
+}
+
+static void publish_schedules(void) {
+    char *json = scheduler_to_json();
+    if (json) {
+        mqtt_publish_bridge("schedules", json, true);
+        cJSON_free(json);
+    }
+}
+
+static void handle_schedule_request(const char* action, const char* payload, int payload_len) {
+    ESP_LOGI(TAG, "Received schedule request: %s", action);
+
+    esp_err_t err = scheduler_handle_request(action, payload, payload_len);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Schedule request %s failed: %s", action, esp_err_to_name(err));
+    }
+
+    // Always echo the current table so the backend sees the effective state
+    publish_schedules();
+}
+
+static void handle_mqtt_request(const char* action, const char* payload, int payload_len) {
+    if (strcmp(action, "stats") != 0) {
+        ESP_LOGW(TAG, "Unknown mqtt request: %s", action);
+        return;
+    }
+
+    mqtt_wire_stats_t stats;
+    mqtt_get_wire_stats(&stats);
+
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "protocol", MQTT_USE_V5 ? "5" : "3.1.1");
+    cJSON_AddNumberToObject(root, "status_messages", stats.status_messages);
+    cJSON_AddNumberToObject(root, "bytes_v311", stats.bytes_v311);
+    cJSON_AddNumberToObject(root, "bytes_sent", stats.bytes_sent);
+    cJSON_AddNumberToObject(root, "alias_hits", stats.alias_hits);
+    if (stats.status_messages > 0) {
+        cJSON_AddNumberToObject(root, "avg_bytes_v311", (double)stats.bytes_v311 / stats.status_messages);
+        cJSON_AddNumberToObject(root, "avg_bytes_sent", (double)stats.bytes_sent / stats.status_messages);
+    }
+
+    char *json = cJSON_PrintUnformatted(root);
+    if (json) {
+        mqtt_publish_bridge("mqtt", json, false);
+        cJSON_free(json);
+    }
+    cJSON_Delete(root);
+}
+
+// Per-peer link quality and estimated ESP-NOW airtime on {prefix}/bridge/link
+static void handle_link_request(const char* action, const char* payload, int payload_len) {
+    if (strcmp(action, "get") != 0) {
+        ESP_LOGW(TAG, "Unknown link request: %s", action);
+        return;
+    }
+
+    static link_peer_t peers[DEVICE_MAX];
+    uint64_t airtime_us = 0;
+    int count = espnow_get_link_stats(peers, DEVICE_MAX, &airtime_us);
+    int64_t uptime_us = esp_timer_get_time();
+
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddNumberToObject(root, "uptime_s", uptime_us / 1000000);
+    cJSON_AddNumberToObject(root, "airtime_ms", airtime_us / 1000.0);
+    cJSON_AddNumberToObject(root, "utilization_pct", uptime_us > 0 ? 100.0 * airtime_us / uptime_us : 0.0);
+    cJSON *peer_array = cJSON_AddArrayToObject(root, "peers");
+    for (int i = 0; i < count; i++) {
+        const link_peer_t *peer = &peers[i];
+        char mac_str[MAC_STR_LEN];
+        mac_bytes_to_str(peer->mac, mac_str);
+
+        cJSON *entry = cJSON_CreateObject();
+        cJSON_AddStringToObject(entry, "mac", mac_str);
+        if (peer->rssi_valid) {
+            cJSON_AddNumberToObject(entry, "rssi", link_peer_rssi(peer));
         }
-        
-        cmd->command = cmd_type;
-        cmd->data_len = data_size;
-        
-        // Fill in data based on command type
-        switch(cmd_type) {
-            case CMD_START:
-                if (data_size > 0) {
-                    // Fill in start command data
-                    // This needs to be adjusted based on your actual data structure
-                }
-                break;
-            case CMD_SYNC:
-                if (data_size > 0) {
-                    // Fill in sync command data
-                    // This needs to be adjusted based on your actual data structure
-                }
-                break;
-            default:
-                break;
+        cJSON_AddStringToObject(entry, "rate", link_rate_name(peer->rate));
+        cJSON_AddNumberToObject(entry, "wire", espnow_get_wire_version(peer->mac));
+        cJSON_AddNumberToObject(entry, "rx", peer->rx_frames);
+        cJSON_AddNumberToObject(entry, "tx", peer->tx_frames);
+        cJSON_AddNumberToObject(entry, "tx_ok", peer->tx_ok);
+        cJSON_AddNumberToObject(entry, "tx_fail", peer->tx_fail);
+        cJSON_AddNumberToObject(entry, "success_pct", link_peer_success_pct(peer));
+        cJSON_AddNumberToObject(entry, "max_fail_streak", peer->max_fail_streak);
+        cJSON_AddNumberToObject(entry, "airtime_ms", peer->airtime_us / 1000.0);
+        cJSON_AddItemToArray(peer_array, entry);
+    }
+
+    char *json = cJSON_PrintUnformatted(root);
+    if (json) {
+        mqtt_publish_bridge("link", json, false);
+        cJSON_free(json);
+    }
+    cJSON_Delete(root);
+}
+
+static void publish_capture_status(esp_err_t err) {
+    espnow_capture_status_t status;
+    espnow_get_capture_status(&status);
+
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "path", CAPTURE_PATH);
+    cJSON_AddBoolToObject(root, "active", status.active);
+    cJSON_AddNumberToObject(root, "frames", status.frames);
+    cJSON_AddNumberToObject(root, "bytes", status.bytes);
+    cJSON_AddNumberToObject(root, "dropped", status.dropped);
+    if (err != ESP_OK) {
+        cJSON_AddStringToObject(root, "error", esp_err_to_name(err));
+    }
+
+    char *json = cJSON_PrintUnformatted(root);
+    if (json) {
+        mqtt_publish_bridge("capture", json, false);
+        cJSON_free(json);
+    }
+    cJSON_Delete(root);
+}
+
+// One hex chunk of the log per request, so it can be pulled without
+// touching the flash (see fetch_capture.sh)
+static void publish_capture_chunk(long offset) {
+    FILE *file = fopen(CAPTURE_PATH, "rb");
+    if (file == NULL) {
+        publish_capture_status(ESP_ERR_NOT_FOUND);
+        return;
+    }
+
+    uint8_t data[CAPTURE_READ_CHUNK];
+    char hex[CAPTURE_READ_CHUNK * 2 + 1];
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    size_t len = 0;
+    if (offset >= 0 && offset < size && fseek(file, offset, SEEK_SET) == 0) {
+        len = fread(data, 1, sizeof(data), file);
+    }
+    fclose(file);
+    hex_encode(data, len, hex);
+
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddNumberToObject(root, "offset", offset);
+    cJSON_AddNumberToObject(root, "size", size);
+    cJSON_AddStringToObject(root, "data", hex);
+    char *json = cJSON_PrintUnformatted(root);
+    if (json) {
+        mqtt_publish_bridge("capture", json, false);
+        cJSON_free(json);
+    }
+    cJSON_Delete(root);
+}
+
+// Room for a new capture log: free space plus the old log it replaces
+static esp_err_t capture_space(size_t *space) {
+    size_t total = 0, used = 0;
+    esp_err_t err = esp_spiffs_info("storage", &total, &used);
+    if (err != ESP_OK) {
+        return err;
+    }
+    struct stat st;
+    *space = (used < total ? total - used : 0) +
+             (stat(CAPTURE_PATH, &st) == 0 ? (size_t)st.st_size : 0);
+    return ESP_OK;
+}
+
+static void handle_capture_request(const char* action, const char* payload, int payload_len) {
+    cJSON *root = payload_len > 0 ? cJSON_ParseWithLength(payload, payload_len) : NULL;
+    esp_err_t err = ESP_OK;
+
+    if (strcmp(action, "start") == 0) {
+        const cJSON *max_kb = cJSON_GetObjectItem(root, "max_kb");
+        size_t space = 0;
+        err = capture_space(&space);
+        if (err == ESP_OK && cJSON_IsNumber(max_kb) && max_kb->valuedouble > 0) {
+            // Compared in KiB first so a huge value cannot overflow size_t
+            if (max_kb->valuedouble > space / 1024) {
+                ESP_LOGW(TAG, "Capture of %.0f KiB exceeds the %u KiB free",
+                         max_kb->valuedouble, (unsigned)(space / 1024));
+                err = ESP_ERR_INVALID_SIZE;
+            } else {
+                err = espnow_capture_start(CAPTURE_PATH, (size_t)max_kb->valuedouble * 1024);
+            }
+        } else if (err == ESP_OK) {
+            err = espnow_capture_start(CAPTURE_PATH,
+                                       space < CAPTURE_MAX_BYTES ? space : CAPTURE_MAX_BYTES);
         }
-        
-        // Send via ESP-NOW
-        espnow_send(mac, cmd);
-        
-        // Free allocated memory
-        free(cmd);
+    } else if (strcmp(action, "stop") == 0) {
+        err = espnow_capture_stop();
+    } else if (strcmp(action, "read") == 0) {
+        const cJSON *offset = cJSON_GetObjectItem(root, "offset");
+        publish_capture_chunk(cJSON_IsNumber(offset) ? (long)offset->valuedouble : 0);
         cJSON_Delete(root);
-    } else {
-        // If no payload, send a simple command with no data
-        command_packet_t cmd = {
-            .command = cmd_type,
-            .data_len = 0
-        };
-        espnow_send(mac, &cmd);
+        return;
+    } else if (strcmp(action, "get") != 0) {
+        ESP_LOGW(TAG, "Unknown capture request: %s", action);
+        cJSON_Delete(root);
+        return;
     }
+
+    cJSON_Delete(root);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Capture %s failed: %s", action, esp_err_to_name(err));
+    }
+    publish_capture_status(err);
+}
+
+static void publish_memory_report(void) {
+    mem_profiler_set_gauge(MEM_SITE_MQTT_OUTBOX, mqtt_get_outbox_size());
+
+    char *json = mem_profiler_report_json();
+    if (json) {
+        mqtt_publish_bridge("memory", json, false);
+        cJSON_free(json);
+    }
+}
+
+static void handle_memory_request(const char* action, const char* payload, int payload_len) {
+    if (strcmp(action, "get") != 0) {
+        ESP_LOGW(TAG, "Unknown memory request: %s", action);
+        return;
+    }
+    publish_memory_report();
+}
+
+static esp_err_t mount_storage(void) {
+    esp_vfs_spiffs_conf_t conf = {
+        .base_path = STORAGE_BASE_PATH,
+        .partition_label = "storage",
+        .max_files = 5,
+        .format_if_mount_failed = false
+    };
+
+    esp_err_t err = esp_vfs_spiffs_register(&conf);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to mount storage partition: %s", esp_err_to_name(err));
+    }
+    return err;
 }
 
 void app_main(void)
 {
+    // Before anything touches cJSON, so every JSON allocation is attributed
+    mem_profiler_install_cjson_hooks();
+    
     ESP_LOGI(TAG, "[APP] Startup..");
     ESP_LOGI(TAG, "[APP] Free memory: %" PRIu32 " bytes", esp_get_free_heap_size());
     ESP_LOGI(TAG, "[APP] IDF version: %s", esp_get_idf_version());
@@ -213,6 +588,9 @@ void app_main(void)
     // Initialize NVS
     ESP_ERROR_CHECK(nvs_flash_init());
     
+    // Mount storage partition; schedules still run from RAM if this fails
+    bool storage_mounted = mount_storage() == ESP_OK;
+    
     // Initialize networking components
     ESP_ERROR_CHECK(esp_netif_init());
     ESP_ERROR_CHECK(esp_event_loop_create_default());
@@ -265,6 +643,19 @@ void app_main(void)
     // Initialize ESPNOW after WiFi is started but before connecting
     espnow_init(handle_espnow_message);
     
+    // Wall clock for the schedule engine
+    setenv("TZ", TIMEZONE, 1);
+    tzset();
+    esp_sntp_config_t sntp_config = ESP_NETIF_SNTP_DEFAULT_CONFIG(SNTP_SERVER);
+    ESP_ERROR_CHECK(esp_netif_sntp_init(&sntp_config));
+    
+    ESP_ERROR_CHECK(rpc_tracker_init(handle_rpc_result));
+    espnow_set_send_result_cb(handle_send_result);
+    
+    // Start local schedules before connecting so they run even without Wi-Fi or a broker
+    ESP_ERROR_CHECK(scheduler_init(send_scheduled, storage_mounted ? SCHEDULES_PATH : NULL));
+    ESP_ERROR_CHECK(mqtt_register_bridge_handler("schedules", handle_schedule_request));
+    
     // Connect to WiFi
     ESP_ERROR_CHECK(esp_wifi_connect());
     
@@ -289,16 +680,33 @@ void app_main(void)
     uint8_t mac[6];
     ESP_ERROR_CHECK(esp_read_mac(mac, ESP_MAC_WIFI_STA));
     
+    char bridge_id[MAC_STR_LEN];
+    mac_bytes_to_str(mac, bridge_id);
+
     // Initialize MQTT with hardcoded config
     mqtt_client_config_t mqtt_cfg = {
         .uri = MQTT_URI,
         .username = MQTT_USERNAME,
-        .password = MQTT_PASSWORD
+        .password = MQTT_PASSWORD,
+        .protocol_v5 = MQTT_USE_V5,
+        .shared_group = FLEET_MODE ? FLEET_SHARED_GROUP : NULL,
+        .bridge_id = FLEET_MODE ? bridge_id : NULL
     };
+    if (FLEET_MODE) {
+        ESP_ERROR_CHECK(fleet_init(bridge_id, run_command));
+        ESP_ERROR_CHECK(mqtt_register_bridge_handler("fleet", fleet_handle_request));
+    }
+    ESP_ERROR_CHECK(mqtt_register_bridge_handler("mqtt", handle_mqtt_request));
+    ESP_ERROR_CHECK(mqtt_register_bridge_handler("memory", handle_memory_request));
+    ESP_ERROR_CHECK(mqtt_register_bridge_handler("link", handle_link_request));
+    ESP_ERROR_CHECK(mqtt_register_bridge_handler("capture", handle_capture_request));
     ESP_ERROR_CHECK(mqtt_init(handle_mqtt_command, &mqtt_cfg, MQTT_TOPIC_PREFIX));
     
     // Publish MAC address
     mqtt_publish_mac_address(mac);
+    publish_schedules();
+    
+    ESP_ERROR_CHECK(mem_profiler_init(MEM_PROFILE_INTERVAL_MS, publish_memory_report));
     
     while(1) {
         vTaskDelay(1000 / portTICK_PERIOD_MS);
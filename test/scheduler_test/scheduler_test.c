@@ -0,0 +1,227 @@
+#include "unity.h"
+#include "timer_wheel.h"
+#include "scheduler.h"
+#include "cJSON.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// 2025-10-19 06:00:00 UTC, a Sunday
+#define TEST_NOW 1760853600
+#define TEST_SCHEDULES_PATH "test_schedules.json"
+#define TEST_ENTRY(fields) "{\"action\":\"START\",\"targets\":[\"aa:bb:cc:dd:ee:ff\"]" fields "}"
+
+static timer_wheel_t wheel;
+static int fired_count;
+static uint32_t last_fired_at;
+
+static void count_fire(timer_wheel_timer_t *timer, void *arg) {
+    fired_count++;
+    last_fired_at = wheel.now;
+    TEST_ASSERT_EQUAL_UINT32(timer->expires, wheel.now);
+}
+
+void setUp(void) {
+    setenv("TZ", "UTC0", 1);
+    tzset();
+    fired_count = 0;
+    last_fired_at = 0;
+    timer_wheel_init(&wheel, TEST_NOW);
+}
+
+void tearDown(void) {
+}
+
+void test_timer_wheel_fires_on_exact_tick(void) {
+    timer_wheel_timer_t timers[4];
+    uint32_t offsets[4] = {1, 63, 64 * 64 + 5, 6 * 24 * 3600};
+
+    for (int i = 0; i < 4; i++) {
+        timer_wheel_timer_init(&timers[i], count_fire, NULL);
+        timer_wheel_add(&wheel, &timers[i], TEST_NOW + offsets[i]);
+    }
+
+    for (int i = 0; i < 4; i++) {
+        timer_wheel_advance(&wheel, TEST_NOW + offsets[i] - 1);
+        TEST_ASSERT_EQUAL(i, fired_count);
+        timer_wheel_advance(&wheel, TEST_NOW + offsets[i]);
+        TEST_ASSERT_EQUAL(i + 1, fired_count);
+        TEST_ASSERT_EQUAL_UINT32(TEST_NOW + offsets[i], last_fired_at);
+    }
+}
+
+void test_timer_wheel_delete_and_past_expiry(void) {
+    timer_wheel_timer_t deleted, late;
+    timer_wheel_timer_init(&deleted, count_fire, NULL);
+    timer_wheel_timer_init(&late, count_fire, NULL);
+
+    timer_wheel_add(&wheel, &deleted, TEST_NOW + 100);
+    timer_wheel_del(&deleted);
+    TEST_ASSERT_FALSE(timer_wheel_pending(&deleted));
+
+    // Already expired timers fire on the next tick instead of being lost
+    timer_wheel_add(&wheel, &late, TEST_NOW - 10);
+    TEST_ASSERT_EQUAL(1, timer_wheel_advance(&wheel, TEST_NOW + 200));
+    TEST_ASSERT_EQUAL_UINT32(TEST_NOW + 1, last_fired_at);
+}
+
+static esp_err_t ignore_send(const uint8_t *mac_addr, const command_packet_t *cmd) {
+    return ESP_OK;
+}
+
+// The scheduler can only be initialized once, so tests share it and start empty
+static void start_scheduler(void) {
+    static bool started = false;
+    if (!started) {
+        remove(TEST_SCHEDULES_PATH);
+        TEST_ASSERT_EQUAL(ESP_OK, scheduler_init(ignore_send, TEST_SCHEDULES_PATH));
+        started = true;
+    }
+    scheduler_clear();
+}
+
+static esp_err_t add(const char *json) {
+    return scheduler_handle_request("add", json, strlen(json));
+}
+
+// Ids of a serialized schedule table, in order; -1 if it does not parse
+static int parse_ids(const char *json, int *ids, int max) {
+    cJSON *root = json ? cJSON_Parse(json) : NULL;
+    if (!cJSON_IsArray(root)) {
+        cJSON_Delete(root);
+        return -1;
+    }
+    int count = 0;
+    const cJSON *entry;
+    cJSON_ArrayForEach(entry, root) {
+        if (count < max) {
+            ids[count] = cJSON_GetObjectItem(entry, "id")->valueint;
+        }
+        count++;
+    }
+    cJSON_Delete(root);
+    return count;
+}
+
+static int table_ids(int *ids, int max) {
+    char *json = scheduler_to_json();
+    int count = parse_ids(json, ids, max);
+    cJSON_free(json);
+    return count;
+}
+
+static int stored_ids(int *ids, int max) {
+    char json[1024] = {0};
+    FILE *f = fopen(TEST_SCHEDULES_PATH, "r");
+    TEST_ASSERT_NOT_NULL(f);
+    fread(json, 1, sizeof(json) - 1, f);
+    fclose(f);
+    return parse_ids(json, ids, max);
+}
+
+void test_add_assigns_ids_and_remove(void) {
+    start_scheduler();
+    int ids[4];
+
+    TEST_ASSERT_EQUAL(ESP_OK, add(TEST_ENTRY(",\"hour\":6")));
+    TEST_ASSERT_EQUAL(ESP_OK, add(TEST_ENTRY(",\"hour\":7")));
+    TEST_ASSERT_EQUAL(2, table_ids(ids, 4));
+    TEST_ASSERT_EQUAL(1, ids[0]);
+    TEST_ASSERT_EQUAL(2, ids[1]);
+
+    TEST_ASSERT_EQUAL(ESP_OK, scheduler_handle_request("remove", "{\"id\":1}", 8));
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, scheduler_remove(1));
+    TEST_ASSERT_EQUAL(1, table_ids(ids, 4));
+    TEST_ASSERT_EQUAL(2, ids[0]);
+}
+
+void test_add_array_auto_ids_skip_explicit_ids(void) {
+    start_scheduler();
+    int ids[4];
+
+    // The id-0 entry must not be replaced by the explicit id that follows it
+    TEST_ASSERT_EQUAL(ESP_OK, add("[" TEST_ENTRY("") "," TEST_ENTRY(",\"id\":1") "]"));
+    TEST_ASSERT_EQUAL(2, table_ids(ids, 4));
+    TEST_ASSERT_EQUAL(2, ids[0]);
+    TEST_ASSERT_EQUAL(1, ids[1]);
+}
+
+void test_add_rejects_out_of_range_fields(void) {
+    start_scheduler();
+    int ids[4];
+
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, add(TEST_ENTRY(",\"minute\":300")));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, add(TEST_ENTRY(",\"hour\":257")));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, add(TEST_ENTRY(",\"minute\":1.5")));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, add(TEST_ENTRY(",\"duration_sec\":-5")));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, add(TEST_ENTRY(",\"days\":200")));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, add(TEST_ENTRY(",\"valve_control\":256")));
+
+    // One bad entry rejects the whole array
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG,
+                      add("[" TEST_ENTRY(",\"hour\":6") "," TEST_ENTRY(",\"hour\":24") "]"));
+    TEST_ASSERT_EQUAL(0, table_ids(ids, 4));
+}
+
+void test_schedules_persisted(void) {
+    start_scheduler();
+    int ids[4];
+
+    TEST_ASSERT_EQUAL(0, stored_ids(ids, 4));
+    TEST_ASSERT_EQUAL(ESP_OK, add("[" TEST_ENTRY(",\"id\":5") "," TEST_ENTRY(",\"id\":9") "]"));
+    TEST_ASSERT_EQUAL(2, stored_ids(ids, 4));
+    TEST_ASSERT_EQUAL(5, ids[0]);
+    TEST_ASSERT_EQUAL(9, ids[1]);
+
+    TEST_ASSERT_EQUAL(ESP_OK, scheduler_remove(5));
+    TEST_ASSERT_EQUAL(1, stored_ids(ids, 4));
+    TEST_ASSERT_EQUAL(9, ids[0]);
+
+    // A failed add leaves the stored table alone
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, add(TEST_ENTRY(",\"minute\":60")));
+    TEST_ASSERT_EQUAL(1, stored_ids(ids, 4));
+}
+
+void test_next_fire_daily(void) {
+    schedule_entry_t entry = {
+        .enabled = true, .action = CMD_START, .minute = 0, .hour = 6,
+        .days = SCHEDULE_ALL_DAYS, .target_count = 1
+    };
+
+    // Exactly at 06:00 the next occurrence is tomorrow
+    TEST_ASSERT_EQUAL(TEST_NOW + 24 * 3600, scheduler_next_fire(&entry, TEST_NOW));
+    TEST_ASSERT_EQUAL(TEST_NOW, scheduler_next_fire(&entry, TEST_NOW - 1));
+}
+
+void test_next_fire_day_mask_and_wildcards(void) {
+    schedule_entry_t entry = {
+        .enabled = true, .action = CMD_STOP, .minute = 0, .hour = 6,
+        .days = 1 << 0, .target_count = 1
+    };
+    TEST_ASSERT_EQUAL(TEST_NOW + 7 * 24 * 3600, scheduler_next_fire(&entry, TEST_NOW));
+
+    entry.days = 1 << 1;
+    TEST_ASSERT_EQUAL(TEST_NOW + 24 * 3600, scheduler_next_fire(&entry, TEST_NOW));
+
+    entry.days = SCHEDULE_ALL_DAYS;
+    entry.hour = SCHEDULE_ANY;
+    entry.minute = 30;
+    TEST_ASSERT_EQUAL(TEST_NOW + 30 * 60, scheduler_next_fire(&entry, TEST_NOW));
+
+    entry.enabled = false;
+    TEST_ASSERT_EQUAL(0, scheduler_next_fire(&entry, TEST_NOW));
+}
+
+void app_main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_timer_wheel_fires_on_exact_tick);
+    RUN_TEST(test_timer_wheel_delete_and_past_expiry);
+    RUN_TEST(test_next_fire_daily);
+    RUN_TEST(test_next_fire_day_mask_and_wildcards);
+    RUN_TEST(test_add_assigns_ids_and_remove);
+    RUN_TEST(test_add_array_auto_ids_skip_explicit_ids);
+    RUN_TEST(test_add_rejects_out_of_range_fields);
+    RUN_TEST(test_schedules_persisted);
+    UNITY_END();
+}